@@ -0,0 +1,160 @@
+#include "batch_scorer.h"
+
+#include <cstring>
+
+using namespace std;
+
+// LANES 32 bit integers, one per move; the compiler turns the arithmetic on them into vector instructions
+typedef int32_t Lanes __attribute__((vector_size(BatchScorer::LANES * sizeof(int32_t))));
+
+BatchScorer::BatchScorer(const Board& board) {
+    for (size_t d = 0; d < 2; d++) {
+        Lines& line = lines[d];
+        line.count = d == 0 ? board.rows : board.columns;
+        line.length = d == 0 ? board.columns : board.rows;
+        size_t squares = line.count * line.length;
+        line.letter_multipliers.assign(squares, 1);
+        line.word_multipliers.assign(squares, 1);
+        line.cross_sums.assign(squares, -1);
+        line.occupied.assign(squares, false);
+        line.run_start.assign(squares, 0);
+        line.run_end.assign(squares, 0);
+        line.sums.assign(line.count * (line.length + 1), 0);
+
+        Direction other = d == 0 ? Direction::DOWN : Direction::ACROSS;
+        for (size_t l = 0; l < line.count; l++) {
+            for (size_t p = 0; p < line.length; p++) {
+                Board::Position position = d == 0 ? Board::Position(l, p) : Board::Position(p, l);
+                const BoardSquare& square = board.square_at(position);
+                size_t i = l * line.length + p;
+                line.sums[l * (line.length + 1) + p + 1] = line.sums[l * (line.length + 1) + p];
+                if (square.has_tile()) {
+                    line.occupied[i] = true;
+                    line.sums[l * (line.length + 1) + p + 1] += square.get_tile_kind().points;
+                    continue;
+                }
+                line.letter_multipliers[i] = square.letter_multiplier;
+                line.word_multipliers[i] = square.word_multiplier;
+                int sum = 0;
+                bool touching = false;
+                for (int step : {-1, 1}) {
+                    for (Board::Position next = position.translate(other, step); board.in_bounds_and_has_tile(next);
+                         next = next.translate(other, step)) {
+                        sum += board.square_at(next).get_tile_kind().points;
+                        touching = true;
+                    }
+                }
+                line.cross_sums[i] = touching ? sum : -1;
+            }
+            // the tiles already on the line right before and right after every square
+            for (size_t p = 0; p < line.length; p++) {
+                size_t i = l * line.length + p;
+                line.run_start[i] = p > 0 && line.occupied[i - 1] ? line.run_start[i - 1] : p;
+            }
+            for (size_t p = line.length; p-- > 0;) {
+                size_t i = l * line.length + p;
+                line.run_end[i] = p + 1 < line.length && line.occupied[i + 1] ? line.run_end[i + 1] : p + 1;
+            }
+        }
+    }
+}
+
+void BatchScorer::score(const CompactMove* moves, size_t count, unsigned int* scores) const {
+    // a batch of LANES moves laid out tile position by tile position, so the kernel reads whole vectors
+    int32_t points[CompactMove::MAX_TILES][LANES];
+    int32_t letter[CompactMove::MAX_TILES][LANES];
+    int32_t word[CompactMove::MAX_TILES][LANES];
+    int32_t cross[CompactMove::MAX_TILES][LANES];
+    int32_t board_points[LANES];
+    int32_t main_word[LANES];
+
+    for (size_t first = 0; first < count; first += LANES) {
+        size_t batch = min(static_cast<size_t>(LANES), count - first);
+
+        // gather: look every tile's square up, and leave the unused tile positions and lanes neutral
+        for (size_t lane = 0; lane < LANES; lane++) {
+            for (size_t t = 0; t < CompactMove::MAX_TILES; t++) {
+                points[t][lane] = 0;
+                letter[t][lane] = 1;
+                word[t][lane] = 1;
+                cross[t][lane] = -1;
+            }
+            board_points[lane] = 0;
+            main_word[lane] = 0;
+            if (lane >= batch) {
+                continue;
+            }
+
+            const CompactMove& move = moves[first + lane];
+            const Lines& line = lines[move.direction == Direction::DOWN ? 1 : 0];
+            size_t l = move.direction == Direction::DOWN ? move.column : move.row;
+            size_t start = move.direction == Direction::DOWN ? move.row : move.column;
+            if (move.kind != MoveKind::PLACE || move.size == 0 || l >= line.count || start >= line.length
+                || line.occupied[l * line.length + start]) {
+                continue;
+            }
+            const size_t base = l * line.length;
+            size_t p = start;
+            size_t last = start;
+            bool fits = true;
+            for (size_t t = 0; t < move.size; t++, p++) {
+                while (p < line.length && line.occupied[base + p]) {
+                    p++;
+                }
+                if (p >= line.length) {
+                    fits = false;
+                    break;
+                }
+                points[t][lane] = move.points[t];
+                letter[t][lane] = line.letter_multipliers[base + p];
+                word[t][lane] = line.word_multipliers[base + p];
+                cross[t][lane] = line.cross_sums[base + p];
+                last = p;
+            }
+            if (!fits) {
+                for (size_t t = 0; t < CompactMove::MAX_TILES; t++) {
+                    cross[t][lane] = -1;
+                }
+                continue;
+            }
+            size_t from = line.run_start[base + start];
+            size_t to = line.run_end[base + last];
+            const int32_t* sums = &line.sums[l * (line.length + 1)];
+            board_points[lane] = sums[to] - sums[from];
+            // a single letter is not a word, so only the cross word scores
+            main_word[lane] = to - from >= 2;
+        }
+
+        // the kernel: every step adds one tile position of all LANES moves to their main and cross words
+        Lanes main;
+        Lanes valid;
+        Lanes multiplier = Lanes{} + 1;
+        Lanes crossed = {};
+        memcpy(&main, board_points, sizeof(main));
+        memcpy(&valid, main_word, sizeof(valid));
+        for (size_t t = 0; t < CompactMove::MAX_TILES; t++) {
+            Lanes p, lm, wm, cs;
+            memcpy(&p, points[t], sizeof(p));
+            memcpy(&lm, letter[t], sizeof(lm));
+            memcpy(&wm, word[t], sizeof(wm));
+            memcpy(&cs, cross[t], sizeof(cs));
+            Lanes placed = p * lm;
+            main += placed;
+            multiplier *= wm;
+            crossed += ((placed + cs) * wm) & (cs >= 0);
+        }
+        Lanes total = main * multiplier * valid + crossed;
+
+        int32_t results[LANES];
+        memcpy(results, &total, sizeof(results));
+        for (size_t lane = 0; lane < batch; lane++) {
+            scores[first + lane] = results[lane];
+        }
+    }
+}
+
+vector<unsigned int> BatchScorer::score(const vector<CompactMove>& moves) const {
+    vector<unsigned int> scores(moves.size());
+    score(moves.data(), moves.size(), scores.data());
+    return scores;
+}
@@ -0,0 +1,66 @@
+#ifndef BATCH_SCORER_H
+#define BATCH_SCORER_H
+
+#include "board.h"
+#include "move.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/*
+Scores many moves on one board at once, for callers that need the points of a whole candidate set rather than one move
+at a time through Board::test_place.
+
+Construction lays the board out once as flat arrays per line, for both directions: the letter and word multiplier of
+every square, the points of the tiles touching it in the other direction, and running sums of the points of the
+tiles along the line. Scoring a batch then looks each move's squares up in those arrays, a move per lane and a tile
+position per step, and adds up the main words and cross words of LANES moves at a time with vector arithmetic:
+no strings, no TileKind copies and no branches per tile.
+
+The points are the ones test_place gives a valid move, without the bingo bonus. Like the move generator, scoring
+trusts the moves to be valid: only that they fit on the board and start on an empty square is checked, and a move
+that does not scores 0. Moves too long or too far out for a CompactMove (see CompactMove::fits) have to be scored with
+test_place instead. The scorer is a snapshot, so it has to be rebuilt once tiles are placed.
+*/
+class BatchScorer {
+  public:
+    // How many moves one step of the kernel scores
+    static const size_t LANES = 8;
+
+    explicit BatchScorer(const Board& board);
+
+    /*
+    Writes the points of moves[i] to scores[i] for every i below count
+    */
+    void score(const CompactMove* moves, size_t count, unsigned int* scores) const;
+
+    std::vector<unsigned int> score(const std::vector<CompactMove>& moves) const;
+
+  private:
+    /*
+    The squares of every line running in one direction, line by line, `length` squares each:
+
+    letter_multipliers, word_multipliers: the square's multipliers, 1 on squares that hold a tile
+    cross_sums: the points of the tiles touching the square in the other direction, -1 if there are none or the
+        square holds a tile
+    occupied: whether the square holds a tile
+    run_start, run_end: the first square of the word a tile on the square would be part of, and one past its last
+        square, counting only the tiles already on the board
+    sums: for each line, length + 1 running sums of the points of the tiles on it, starting from 0
+    */
+    struct Lines {
+        size_t count = 0;
+        size_t length = 0;
+        std::vector<int32_t> letter_multipliers;
+        std::vector<int32_t> word_multipliers;
+        std::vector<int32_t> cross_sums;
+        std::vector<char> occupied;
+        std::vector<uint16_t> run_start;
+        std::vector<uint16_t> run_end;
+        std::vector<int32_t> sums;
+    };
+
+    Lines lines[2];  // ACROSS (one per row), DOWN (one per column)
+};
+
+#endif
@@ -0,0 +1,306 @@
+#include "batch_scorer.h"
+#include "board.h"
+#include "computer_player.h"
+#include "dictionary.h"
+#include "scrabble_config.h"
+#include "tile_bag.h"
+#include "transposition_cache.h"
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// A position to search: the board and the rack of the player to move
+struct Position {
+    Board board;
+    vector<TileKind> rack;
+};
+
+bool same_move(const Move& a, const Move& b) {
+    if (a.kind != b.kind || a.tiles.size() != b.tiles.size()) {
+        return false;
+    }
+    if (a.kind == MoveKind::PLACE && (a.row != b.row || a.column != b.column || a.direction != b.direction)) {
+        return false;
+    }
+    for (size_t i = 0; i < a.tiles.size(); i++) {
+        if (a.tiles[i].letter != b.tiles[i].letter || a.tiles[i].assigned != b.tiles[i].assigned) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Plays games against itself from the configuration and records every position along the way.
+// A game ends when the bag runs out or the player to move has to pass.
+vector<Position> play_positions(const ScrabbleConfig& config, const Dictionary& dictionary, size_t count) {
+    vector<Position> positions;
+    for (uint32_t game = 0; positions.size() < count; game++) {
+        Board board = Board::read(config.board_file_path);
+        TileBag bag = TileBag::read(config.tile_bag_file_path, config.seed + game);
+        vector<ComputerPlayer> players(2, ComputerPlayer("cpu", config.hand_size));
+        for (size_t i = 0; i < players.size(); i++) {
+            players[i].set_engine(ComputerPlayer::Engine::GADDAG);
+            players[i].add_tiles(bag.remove_random_tiles(config.hand_size));
+        }
+
+        for (size_t turn = 0; positions.size() < count; turn = (turn + 1) % players.size()) {
+            ComputerPlayer& player = players[turn];
+            Position position{board, player.get_tiles()};
+            Move move = player.get_move(board, dictionary);
+            if (move.kind != MoveKind::PLACE || bag.count_tiles() < move.tiles.size()) {
+                break;
+            }
+            positions.push_back(position);
+            board.place(move);
+            player.remove_tiles(move.tiles);
+            player.add_tiles(bag.remove_random_tiles(move.tiles.size()));
+        }
+    }
+    return positions;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        cerr << "Usage: " << argv[0] << " <configuration file> [positions]" << endl;
+        return 1;
+    }
+    size_t count = argc > 2 ? stoul(argv[2]) : 20;
+
+    ScrabbleConfig config;
+    Dictionary dictionary;
+    try {
+        config = ScrabbleConfig::read(argv[1]);
+        dictionary = Dictionary::read(config.dictionary_file_path);
+    } catch (const FileException& e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+
+    auto start = chrono::steady_clock::now();
+    dictionary.build_gaddag();
+    double build_ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    cout << "gaddag: " << dictionary.get_gaddag()->node_count() << " nodes, " << dictionary.get_gaddag()->edge_count()
+         << " edges, built in " << fixed << setprecision(1) << build_ms << " ms" << endl;
+
+    vector<Position> positions = play_positions(config, dictionary, count);
+
+    const ComputerPlayer::Engine engines[] = {ComputerPlayer::Engine::TRIE, ComputerPlayer::Engine::GADDAG};
+    const char* names[] = {"trie", "gaddag"};
+    // every engine searches every position exhaustively, then with pruning
+    double total_ms[2][2] = {{0, 0}, {0, 0}};
+    size_t total_nodes[2][2] = {{0, 0}, {0, 0}};
+    size_t mismatches = 0;
+    size_t skipped = 0;
+    size_t anchors = 0;
+
+    cout << setw(8) << "position";
+    for (size_t e = 0; e < 2; e++) {
+        cout << setw(14) << string(names[e]) + " nodes" << setw(10) << "pruned" << setw(10) << "ms" << setw(10)
+             << "pruned ms";
+    }
+    cout << setw(8) << "score" << endl;
+    for (size_t i = 0; i < positions.size(); i++) {
+        ComputerPlayer player("cpu", config.hand_size);
+        player.add_tiles(positions[i].rack);
+
+        vector<Move> moves;
+        cout << setw(8) << i + 1;
+        for (size_t e = 0; e < 2; e++) {
+            size_t nodes[2];
+            double ms[2];
+            for (size_t pruning = 0; pruning < 2; pruning++) {
+                // a fresh engine, so the search cannot lean on the line cache of the last one
+                player.set_engine(engines[e]);
+                player.set_pruning(pruning == 1);
+                start = chrono::steady_clock::now();
+                moves.push_back(player.get_move(positions[i].board, dictionary));
+                ms[pruning] = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+                nodes[pruning] = player.get_nodes_visited();
+                if (pruning == 1 && e == 1) {
+                    skipped += player.get_anchors_skipped();
+                    anchors += positions[i].board.get_anchors().size();
+                }
+                total_ms[e][pruning] += ms[pruning];
+                total_nodes[e][pruning] += nodes[pruning];
+            }
+            cout << setw(14) << nodes[0] << setw(10) << nodes[1] << setw(10) << ms[0] << setw(10) << ms[1];
+        }
+        unsigned int points[4] = {0, 0, 0, 0};
+        for (size_t m = 0; m < moves.size(); m++) {
+            if (moves[m].kind == MoveKind::PLACE) {
+                points[m] = positions[i].board.test_place(moves[m]).points;
+            }
+        }
+        cout << setw(8) << points[0] << endl;
+        // pruning has to find the very same move as the exhaustive search, and both engines the same score
+        if (!same_move(moves[0], moves[1]) || !same_move(moves[2], moves[3]) || points[0] != points[2]) {
+            mismatches++;
+        }
+    }
+
+    cout << endl << "per get_move over " << positions.size() << " positions:" << endl;
+    for (size_t e = 0; e < 2; e++) {
+        cout << setw(8) << names[e] << setw(14) << total_nodes[e][0] / positions.size() << " nodes" << setw(12)
+             << total_ms[e][0] / positions.size() << " ms, pruned" << setw(12) << total_nodes[e][1] / positions.size()
+             << " nodes" << setw(12) << total_ms[e][1] / positions.size() << " ms" << endl;
+    }
+    cout << "anchors the pruned gaddag search skipped: " << skipped << " of " << anchors << endl;
+
+    // an analysis that comes back to positions it has seen finds them in a shared cache the second time around
+    shared_ptr<TranspositionCache> cache = make_shared<TranspositionCache>(1 << 16);
+    double pass_ms[2] = {0, 0};
+    vector<Move> first_pass;
+    for (size_t pass = 0; pass < 2; pass++) {
+        for (size_t i = 0; i < positions.size(); i++) {
+            ComputerPlayer player("cpu", config.hand_size);
+            player.set_engine(ComputerPlayer::Engine::GADDAG);
+            player.set_transposition_cache(cache);
+            player.add_tiles(positions[i].rack);
+            start = chrono::steady_clock::now();
+            Move move = player.get_move(positions[i].board, dictionary);
+            pass_ms[pass] += chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+            if (pass == 0) {
+                first_pass.push_back(move);
+            } else if (!same_move(move, first_pass[i])) {
+                mismatches++;
+            }
+        }
+    }
+    TranspositionCache::Stats stats = cache->get_stats();
+    cout << "transposition cache: " << setprecision(3) << pass_ms[0] / positions.size() << " ms searching, "
+         << pass_ms[1] / positions.size() << " ms replayed, " << stats.hits << " hits, " << stats.misses
+         << " misses" << endl;
+
+    // capped efforts give up the best move for speed: how many of the best move's points they keep, and how fast
+    struct Tier {
+        const char* name;
+        ComputerPlayer::Effort effort;
+    };
+    vector<Tier> tiers(6);
+    tiers[0].name = "full";
+    tiers[1].name = "256 nodes/anchor";
+    tiers[1].effort.anchor_nodes = 256;
+    tiers[2].name = "32 nodes/anchor";
+    tiers[2].effort.anchor_nodes = 32;
+    tiers[3].name = "first 20 points";
+    tiers[3].effort.good_enough = 20;
+    tiers[4].name = "greedy";
+    tiers[4].effort.greedy = true;
+    tiers[5].name = "greedy, 32 nodes";
+    tiers[5].effort.greedy = true;
+    tiers[5].effort.anchor_nodes = 32;
+    vector<size_t> best_points;
+    cout << endl << setw(18) << "effort" << setw(12) << "nodes" << setw(12) << "ms" << setw(12) << "moves/s"
+         << setw(10) << "points" << setw(10) << "of best" << endl;
+    for (const Tier& tier : tiers) {
+        size_t nodes = 0;
+        size_t points = 0;
+        double ms = 0;
+        for (size_t i = 0; i < positions.size(); i++) {
+            ComputerPlayer player("cpu", config.hand_size);
+            player.set_engine(ComputerPlayer::Engine::GADDAG);
+            player.set_effort(tier.effort);
+            player.add_tiles(positions[i].rack);
+            start = chrono::steady_clock::now();
+            Move move = player.get_move(positions[i].board, dictionary);
+            ms += chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+            nodes += player.get_nodes_visited();
+            size_t scored = move.kind == MoveKind::PLACE ? positions[i].board.test_place(move).points : 0;
+            if (best_points.size() < positions.size()) {
+                best_points.push_back(scored);
+            }
+            points += scored;
+        }
+        size_t best = 0;
+        for (size_t scored : best_points) {
+            best += scored;
+        }
+        cout << setw(18) << tier.name << setw(12) << nodes / positions.size() << setw(12) << ms / positions.size()
+             << setw(12) << setprecision(0) << positions.size() / ms * 1000 << setprecision(3) << setw(10)
+             << static_cast<double>(points) / positions.size() << setw(9) << setprecision(1)
+             << 100.0 * points / best << "%" << setprecision(3) << endl;
+    }
+
+    // every legal move of every position scored one at a time by test_place, then all at once by a BatchScorer
+    const size_t repeats = 20;
+    size_t scored = 0;
+    double scalar_ms = 0;
+    double batch_ms = 0;
+    double build_scorer_ms = 0;
+    for (size_t i = 0; i < positions.size(); i++) {
+        ComputerPlayer player("cpu", config.hand_size);
+        player.set_engine(ComputerPlayer::Engine::GADDAG);
+        player.add_tiles(positions[i].rack);
+        vector<Move> legal = player.get_legal_moves(positions[i].board, dictionary);
+        vector<Move> moves;
+        vector<CompactMove> compact;
+        for (const Move& move : legal) {
+            if (CompactMove::fits(move)) {
+                moves.push_back(move);
+                compact.push_back(CompactMove(move));
+            }
+        }
+        const Board& board = positions[i].board;
+        vector<unsigned int> scalar(compact.size());
+        start = chrono::steady_clock::now();
+        for (size_t r = 0; r < repeats; r++) {
+            for (size_t m = 0; m < compact.size(); m++) {
+                scalar[m] = board.test_place(moves[m]).points;
+            }
+        }
+        scalar_ms += chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+
+        start = chrono::steady_clock::now();
+        BatchScorer scorer(board);
+        build_scorer_ms += chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+        vector<unsigned int> batch(compact.size());
+        start = chrono::steady_clock::now();
+        for (size_t r = 0; r < repeats; r++) {
+            scorer.score(compact.data(), compact.size(), batch.data());
+        }
+        batch_ms += chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+        if (batch != scalar) {
+            mismatches++;
+        }
+        scored += compact.size() * repeats;
+    }
+    cout << endl << "scoring " << scored / repeats << " legal moves " << repeats << " times: test_place "
+         << setprecision(0) << scored / scalar_ms * 1000 << " moves/s, batch " << scored / batch_ms * 1000
+         << " moves/s, " << setprecision(3) << build_scorer_ms / positions.size() << " ms to lay out a board" << endl;
+
+    // the same legal moves handed out one at a time by the resumable search, without ever holding them all
+    double listed_ms = 0;
+    double enumerated_ms = 0;
+    for (size_t i = 0; i < positions.size(); i++) {
+        ComputerPlayer player("cpu", config.hand_size);
+        player.set_engine(ComputerPlayer::Engine::GADDAG);
+        player.set_threads(1);
+        player.add_tiles(positions[i].rack);
+        start = chrono::steady_clock::now();
+        vector<Move> legal = player.get_legal_moves(positions[i].board, dictionary);
+        listed_ms += chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+        start = chrono::steady_clock::now();
+        ComputerPlayer::MoveEnumerator moves = player.enumerate_moves(positions[i].board, dictionary);
+        Move move;
+        size_t count = 0;
+        while (moves.next(move)) {
+            if (count >= legal.size() || !same_move(move, legal[count])) {
+                mismatches++;
+            }
+            count++;
+        }
+        enumerated_ms += chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+        if (count != legal.size()) {
+            mismatches++;
+        }
+    }
+    cout << "legal moves per position: " << listed_ms / positions.size() << " ms listed, "
+         << enumerated_ms / positions.size() << " ms enumerated one at a time" << endl;
+    cout << endl << "best moves that differ: " << mismatches << endl;
+    return mismatches == 0 ? 0 : 1;
+}
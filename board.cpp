@@ -3,11 +3,16 @@
 #include "board_square.h"
 #include "exceptions.h"
 #include "formatting.h"
+#include "zobrist.h"
+#include <atomic>
 #include <fstream>
 #include <iomanip>
 
 using namespace std;
 
+// Every line stamp ever handed out is unique, even across boards
+static atomic<uint64_t> next_line_stamp(1);
+
 bool Board::Position::operator==(const Board::Position& other) const {
     return this->row == other.row && this->column == other.column;
 }
@@ -58,6 +63,14 @@ Board Board::read(const string& file_path) {
             }
         }
     }
+    board.line_stamps[0].resize(rows);
+    board.line_stamps[1].resize(columns);
+    for (size_t i = 0; i < rows; i++) {
+        board.mark_dirty(Direction::ACROSS, i);
+    }
+    for (size_t j = 0; j < columns; j++) {
+        board.mark_dirty(Direction::DOWN, j);
+    }
     return board;
 }
 
@@ -106,6 +119,9 @@ PlaceResult Board::test_Down(const Move& move) const {
     // if there are squares with existing tiles in between where the tiles would be placed,
     // add those letters to the back of the 's' string and update points
     for (size_t i = 0, j = 0; i != move.tiles.size(); j++) {
+        if (!is_in_bounds(Position(move.row + j, move.column))) {
+            return PlaceResult("Out of bounds");
+        }
         if (squares[move.row + j][move.column].has_tile()) {
             hasAdjacent = true;
             if (squares[move.row + j][move.column].get_tile_kind().letter == TileKind::BLANK_LETTER) {
@@ -164,6 +180,10 @@ PlaceResult Board::test_Down(const Move& move) const {
             len++;
             continue;
         }
+        // every placed tile has been checked, the rest of the word was already on the board
+        if (i - len >= move.tiles.size()) {
+            break;
+        }
         if ((in_bounds_and_has_tile(Position(move.row + i, move.column + 1))
              && !in_bounds_and_has_tile(Position(move.row + i, move.column)))
             || (in_bounds_and_has_tile(Position(move.row + i, move.column - 1))
@@ -178,7 +198,7 @@ PlaceResult Board::test_Down(const Move& move) const {
             subpoints += move.tiles[i - len].points * squares[move.row + i][move.column].letter_multiplier;
             bonus *= squares[move.row + i][move.column].word_multiplier;
             // adds all the tiles on the left
-            for (size_t j = 1; squares[move.row + i][move.column - j].has_tile(); j++) {
+            for (size_t j = 1; in_bounds_and_has_tile(Position(move.row + i, move.column - j)); j++) {
                 if (squares[move.row + i][move.column - j].get_tile_kind().letter == TileKind::BLANK_LETTER) {
                     str.insert(0, 1, squares[move.row + i][move.column - j].get_tile_kind().assigned);
                 } else {
@@ -188,7 +208,7 @@ PlaceResult Board::test_Down(const Move& move) const {
             }
 
             // adds all the tiles on the right
-            for (size_t j = 1; squares[move.row + i][move.column + j].has_tile(); j++) {
+            for (size_t j = 1; in_bounds_and_has_tile(Position(move.row + i, move.column + j)); j++) {
                 if (squares[move.row + i][move.column + j].get_tile_kind().letter == TileKind::BLANK_LETTER) {
                     str.push_back(squares[move.row + i][move.column + j].get_tile_kind().assigned);
                 } else {
@@ -256,6 +276,9 @@ PlaceResult Board::test_Across(const Move& move) const {
     // if there are squares with existing tiles in between where the tiles would be placed,
     // add those letters to the back of the 's' string and update points
     for (size_t j = 0, i = 0; i != move.tiles.size(); j++) {
+        if (!is_in_bounds(Position(move.row, move.column + j))) {
+            return PlaceResult("Out of bounds");
+        }
         if (squares[move.row][move.column + j].has_tile()) {
             hasAdjacent = true;
             if (squares[move.row][move.column + j].get_tile_kind().letter == TileKind::BLANK_LETTER) {
@@ -315,6 +338,10 @@ PlaceResult Board::test_Across(const Move& move) const {
             len++;
             continue;
         }
+        // every placed tile has been checked, the rest of the word was already on the board
+        if (i - len >= move.tiles.size()) {
+            break;
+        }
         if ((in_bounds_and_has_tile(Position(move.row + 1, move.column + i))
              && !in_bounds_and_has_tile(Position(move.row, move.column + i)))
             || (in_bounds_and_has_tile(Position(move.row - 1, move.column + i))
@@ -330,7 +357,7 @@ PlaceResult Board::test_Across(const Move& move) const {
             bonus *= squares[move.row][move.column + i].word_multiplier;
 
             // processes all squares above
-            for (size_t j = 1; squares[move.row - j][move.column + i].has_tile(); j++) {
+            for (size_t j = 1; in_bounds_and_has_tile(Position(move.row - j, move.column + i)); j++) {
                 if (squares[move.row - j][move.column + i].get_tile_kind().letter == TileKind::BLANK_LETTER) {
                     str.insert(0, 1, squares[move.row - j][move.column + i].get_tile_kind().assigned);
                 } else {
@@ -341,7 +368,7 @@ PlaceResult Board::test_Across(const Move& move) const {
             }
 
             // processes all squares below
-            for (size_t j = 1; squares[move.row + j][move.column + i].has_tile(); j++) {
+            for (size_t j = 1; in_bounds_and_has_tile(Position(move.row + j, move.column + i)); j++) {
                 if (squares[move.row + j][move.column + i].get_tile_kind().letter == TileKind::BLANK_LETTER) {
                     str.push_back(squares[move.row + j][move.column + i].get_tile_kind().assigned);
                 } else {
@@ -383,13 +410,18 @@ PlaceResult Board::place(const Move& move) {
     if (!test.valid) {
         return test;
     }
-    // permanently place the tiles on the board
+    // permanently place the tiles on the board, remembering enough to take them back
+    history.placements.push_back(Placement());
+    Placement& undo = history.placements.back();
+    vector<Position>& placed = undo.squares;
     if (move.direction == Direction::DOWN) {
         for (size_t i = 0, j = 0; i != move.tiles.size(); j++) {
             if (squares[move.row + j][move.column].has_tile()) {
                 continue;
             }
             squares[move.row + j][move.column].set_tile_kind(move.tiles[i]);
+            placed.push_back(Position(move.row + j, move.column));
+            hash ^= tile_key(placed.back(), move.tiles[i]);
             i++;
         }
     } else {
@@ -398,12 +430,76 @@ PlaceResult Board::place(const Move& move) {
                 continue;
             }
             squares[move.row][move.column + j].set_tile_kind(move.tiles[i]);
+            placed.push_back(Position(move.row, move.column + j));
+            hash ^= tile_key(placed.back(), move.tiles[i]);
             i++;
         }
     }
+
+    // every line through a new tile changes, and so does the line through each square at either end of the words
+    // the tile is part of: that square's cross check, and whether it is an anchor, depend on the word
+    for (size_t i = 0; i < placed.size(); i++) {
+        mark_dirty(Direction::ACROSS, placed[i].row, &undo);
+        mark_dirty(Direction::DOWN, placed[i].column, &undo);
+        for (Direction direction : {Direction::ACROSS, Direction::DOWN}) {
+            Position before = placed[i].translate(direction, -1);
+            while (in_bounds_and_has_tile(before)) {
+                before = before.translate(direction, -1);
+            }
+            Position after = placed[i].translate(direction);
+            while (in_bounds_and_has_tile(after)) {
+                after = after.translate(direction);
+            }
+            // the end squares lie on lines running the other way
+            for (Position end : {before, after}) {
+                if (is_in_bounds(end)) {
+                    mark_dirty(!direction, direction == Direction::ACROSS ? end.column : end.row, &undo);
+                }
+            }
+        }
+    }
     return test;
 }
 
+void Board::undo_place() {
+    if (history.placements.empty()) {
+        return;
+    }
+    Placement& undo = history.placements.back();
+    for (size_t i = 0; i < undo.squares.size(); i++) {
+        hash ^= tile_key(undo.squares[i], at(undo.squares[i]).get_tile_kind());
+        at(undo.squares[i]).clear_tile_kind();
+    }
+    // the lines are back to what they were, so they can have their old stamps back too; a line restamped more than
+    // once gets the stamp it had before the first
+    for (size_t i = undo.restamps.size(); i-- > 0;) {
+        const Restamp& restamp = undo.restamps[i];
+        line_stamps[restamp.direction == Direction::DOWN ? 1 : 0][restamp.line] = restamp.stamp;
+    }
+    history.placements.pop_back();
+}
+
+uint64_t Board::get_hash() const { return hash; }
+
+uint64_t Board::tile_key(const Position& position, const TileKind& tile) const {
+    bool blank = tile.letter == TileKind::BLANK_LETTER;
+    char letter = blank ? tile.assigned : tile.letter;
+    // 64 codes per square: the letters, then the same letters played with a blank
+    return zobrist_key((position.row * columns + position.column) * 64 + (letter & 31) + (blank ? 32 : 0));
+}
+
+uint64_t Board::get_line_stamp(Direction direction, size_t line) const {
+    return line_stamps[direction == Direction::DOWN ? 1 : 0].at(line);
+}
+
+void Board::mark_dirty(Direction direction, size_t line, Placement* undo) {
+    uint64_t& stamp = line_stamps[direction == Direction::DOWN ? 1 : 0].at(line);
+    if (undo != nullptr) {
+        undo->restamps.push_back(Restamp{direction, line, stamp});
+    }
+    stamp = next_line_stamp++;
+}
+
 // The rest of this file is provided for you. No need to make changes.
 
 BoardSquare& Board::at(const Board::Position& position) { return this->squares.at(position.row).at(position.column); }
@@ -518,6 +614,8 @@ char Board::letter_at(Position p) const {
     return at(p).get_tile_kind().letter;
 }
 
+const BoardSquare& Board::square_at(Position p) const { return at(p); }
+
 bool Board::is_anchor_spot(Position p) const {
     if (!is_in_bounds(p) || in_bounds_and_has_tile(p)) {
         return false;
@@ -6,6 +6,7 @@
 #include "move.h"
 #include "place_result.h"
 #include "tile_kind.h"
+#include <cstdint>
 #include <ostream>
 #include <string>
 #include <vector>
@@ -67,6 +68,28 @@ class Board {
     PlaceResult place(const Move& move);  // Used for testing - remember that the move struct should use 0 based
                                           // indexing, NOT 1 based
 
+    /*
+    Takes back the most recent place() that has not been taken back yet, restoring the board exactly as it was,
+    line stamps and hash included. Lets searches make and unmake moves instead of copying the board.
+    Only places made on this board can be taken back: a copy of a board starts with nothing to take back.
+    */
+    void undo_place();
+
+    /*
+    Returns the Zobrist hash of the tiles on the board: the same tiles on the same squares always hash the same,
+    however they got there
+    */
+    uint64_t get_hash() const;
+
+    /*
+    Returns the stamp of a line: the row `line` for ACROSS, the column `line` for DOWN.
+
+    place() gives a fresh stamp to every line whose moves it may have changed, which is every line through a new tile
+    and every line through a square at the end of a word the new tiles are part of. Stamps are never reused, so two
+    boards with the same stamp for a line have the same moves along it and move generators can cache them.
+    */
+    uint64_t get_line_stamp(Direction direction, size_t line) const;
+
     void print(std::ostream& out) const;
 
     // Note: These methods have been made public
@@ -79,6 +102,12 @@ class Board {
     */
     char letter_at(Position p) const;
 
+    /*
+    Returns the square at a position, with its multipliers and tile.
+    Assumes p is in bounds
+    */
+    const BoardSquare& square_at(Position p) const;
+
     /* HW5: IMPLEMENT THIS
     Returns bool indicating whether position p is an anchor spot or not.
 
@@ -108,6 +137,41 @@ class Board {
     const BoardSquare& at(const Position& position) const;
 
     std::vector<std::vector<BoardSquare>> squares;
+    std::vector<uint64_t> line_stamps[2];  // ACROSS (one per row), DOWN (one per column)
+    uint64_t hash = 0;
+
+    // A line place() gave a fresh stamp, and the stamp it had before
+    struct Restamp {
+        Direction direction;
+        size_t line;
+        uint64_t stamp;
+    };
+
+    // What undo_place needs to take a place() back: the squares it filled and the lines it restamped, in order
+    struct Placement {
+        std::vector<Position> squares;
+        std::vector<Restamp> restamps;
+    };
+
+    // The places not taken back yet. A copy of a board starts with none, so copying a board never copies the history
+    // of the one it came from, and undo_place only takes back places made on the copy itself.
+    struct History {
+        std::vector<Placement> placements;
+
+        History() {}
+        History(const History&) {}
+        History& operator=(const History&) {
+            placements.clear();
+            return *this;
+        }
+    };
+    History history;
+
+    // The Zobrist key of tile on the square at position
+    uint64_t tile_key(const Position& position, const TileKind& tile) const;
+
+    // Gives a line a fresh stamp, recording the old one in undo if given
+    void mark_dirty(Direction direction, size_t line, Placement* undo = nullptr);
     size_t move_index = 0;
 };
 
@@ -14,6 +14,9 @@ class BoardSquare {
     bool has_tile() const;
     TileKind get_tile_kind() const;
     void set_tile_kind(TileKind kind);
+
+    // Takes the tile off the square again
+    void clear_tile_kind();
     unsigned int get_points() const;
 
   private:
@@ -1,19 +1,31 @@
 
 #include "computer_player.h"
 
+#include "endgame_solver.h"
+#include "strategy.h"
+#include "zobrist.h"
+
+#include <algorithm>
+#include <cctype>
+#include <iterator>
+#include <limits>
 #include <memory>
+#include <random>
 #include <string>
 
 
 void ComputerPlayer::left_part(
         Board::Position anchor_pos,
         std::string partial_word,
-        Move partial_move,
+        Move& partial_move,
         std::shared_ptr<Dictionary::TrieNode> node,
         size_t limit,
-        TileCollection& remaining_tiles,
-        std::vector<Move>& legal_moves,
+        SearchContext& search,
         const Board& board) const {
+    search.nodes++;
+    if (out_of_budget(search)) {
+        return;
+    }
 
     if (partial_move.direction == Direction::DOWN) {
         partial_move.row = anchor_pos.row - partial_word.size();
@@ -21,37 +33,41 @@ void ComputerPlayer::left_part(
         partial_move.column = anchor_pos.column - partial_word.size();
     }
     // call extend right on every recursive call
-    extend_right(anchor_pos, partial_word, partial_move, node, remaining_tiles, legal_moves, board);
+    extend_right(anchor_pos, partial_word, partial_move, node, search, board);
 
     if (limit == 0) {
         return;
     }
 
     for (auto it = node->nexts.begin(); it != node->nexts.end(); it++) {
+        // no tile, not even a blank, can stand for punctuation like the apostrophe in "i'm"
+        if (!std::isalpha(it->first)) {
+            continue;
+        }
+        search.stats.rack_lookups += 2;
         // check if player has blank tile
         try {
-            TileKind add(remaining_tiles.lookup_tile(TileKind::BLANK_LETTER));
+            TileKind add(search.remaining_tiles.lookup_tile(TileKind::BLANK_LETTER));
             add.assigned = it->first;
             partial_move.tiles.push_back(add);
-            remaining_tiles.remove_tile(remaining_tiles.lookup_tile(TileKind::BLANK_LETTER));
+            search.remaining_tiles.remove_tile(search.remaining_tiles.lookup_tile(TileKind::BLANK_LETTER));
             left_part(
                     anchor_pos,
                     partial_word + it->first,
                     partial_move,
                     it->second,
                     limit - 1,
-                    remaining_tiles,
-                    legal_moves,
+                    search,
                     board);
             // backtrack
-            remaining_tiles.add_tile(partial_move.tiles.back());
+            search.remaining_tiles.add_tile(partial_move.tiles.back());
             partial_move.tiles.pop_back();
         } catch (std::out_of_range& e) {
         }
         // check if player has specific tile
         try {
-            partial_move.tiles.push_back(remaining_tiles.lookup_tile(it->first));
-            remaining_tiles.remove_tile(remaining_tiles.lookup_tile(it->first));
+            partial_move.tiles.push_back(search.remaining_tiles.lookup_tile(it->first));
+            search.remaining_tiles.remove_tile(search.remaining_tiles.lookup_tile(it->first));
         } catch (std::out_of_range& e) {
             continue;
         }
@@ -61,11 +77,10 @@ void ComputerPlayer::left_part(
                 partial_move,
                 it->second,
                 limit - 1,
-                remaining_tiles,
-                legal_moves,
+                search,
                 board);
         // backtrack
-        remaining_tiles.add_tile(partial_move.tiles.back());
+        search.remaining_tiles.add_tile(partial_move.tiles.back());
         partial_move.tiles.pop_back();
     }
 }
@@ -73,14 +88,31 @@ void ComputerPlayer::left_part(
 void ComputerPlayer::extend_right(
         Board::Position square,
         std::string partial_word,
-        Move partial_move,
+        Move& partial_move,
         std::shared_ptr<Dictionary::TrieNode> node,
-        TileCollection& remaining_tiles,
-        std::vector<Move>& legal_moves,
+        SearchContext& search,
         const Board& board) const {
+    search.nodes++;
+    if (out_of_budget(search)) {
+        return;
+    }
+    static const std::vector<TileKind> no_tiles;
+    if (search.bounds != nullptr) {
+        Board::Position start(partial_move.row, partial_move.column);
+        size_t bound
+                = placement_bound(partial_move.direction, start, square, no_tiles, partial_move.tiles, search, board);
+        if (prune(bound, search)) {
+            return;
+        }
+    }
 
     if (node->is_final) {
-        legal_moves.push_back(partial_move);
+        // with a tile on the next square the word goes on, and this placement is recorded once it ends
+        if (board.in_bounds_and_has_tile(square)) {
+            search.duplicates++;
+        } else {
+            record(search, partial_move, board);
+        }
     }
     if (!board.is_in_bounds(square)) {
         return;
@@ -88,29 +120,33 @@ void ComputerPlayer::extend_right(
 
     if (!board.in_bounds_and_has_tile(square)) {
         for (auto it = node->nexts.begin(); it != node->nexts.end(); it++) {
+            // no tile, not even a blank, can stand for punctuation like the apostrophe in "i'm"
+            if (!std::isalpha(it->first)) {
+                continue;
+            }
+            search.stats.rack_lookups += 2;
             // check if player has blank tile
             try {
-                TileKind add(remaining_tiles.lookup_tile(TileKind::BLANK_LETTER));
+                TileKind add(search.remaining_tiles.lookup_tile(TileKind::BLANK_LETTER));
                 add.assigned = it->first;
                 partial_move.tiles.push_back(add);
-                remaining_tiles.remove_tile(remaining_tiles.lookup_tile(TileKind::BLANK_LETTER));
+                search.remaining_tiles.remove_tile(search.remaining_tiles.lookup_tile(TileKind::BLANK_LETTER));
                 extend_right(
                         square.translate(partial_move.direction),
                         partial_word + it->first,
                         partial_move,
                         it->second,
-                        remaining_tiles,
-                        legal_moves,
+                        search,
                         board);
                 // backtrack
-                remaining_tiles.add_tile(partial_move.tiles.back());
+                search.remaining_tiles.add_tile(partial_move.tiles.back());
                 partial_move.tiles.pop_back();
             } catch (std::out_of_range& e) {
             }
             // check if player has specific tile
             try {
-                partial_move.tiles.push_back(remaining_tiles.lookup_tile(it->first));
-                remaining_tiles.remove_tile(remaining_tiles.lookup_tile(it->first));
+                partial_move.tiles.push_back(search.remaining_tiles.lookup_tile(it->first));
+                search.remaining_tiles.remove_tile(search.remaining_tiles.lookup_tile(it->first));
             } catch (std::out_of_range& e) {
                 continue;
             }
@@ -119,11 +155,10 @@ void ComputerPlayer::extend_right(
                     partial_word + it->first,
                     partial_move,
                     it->second,
-                    remaining_tiles,
-                    legal_moves,
+                    search,
                     board);
             // backtrack
-            remaining_tiles.add_tile(partial_move.tiles.back());
+            search.remaining_tiles.add_tile(partial_move.tiles.back());
             partial_move.tiles.pop_back();
         }
         // if next square is not vacant
@@ -135,94 +170,1987 @@ void ComputerPlayer::extend_right(
                     partial_word + board.letter_at(square),
                     partial_move,
                     node->nexts.find(board.letter_at(square))->second,
-                    remaining_tiles,
-                    legal_moves,
+                    search,
                     board);
         }
     }
 }
 
-Move ComputerPlayer::get_move(const Board& board, const Dictionary& dictionary) const {
-    std::vector<Move> legal_moves;
-    std::vector<Board::Anchor> anchors = board.get_anchors();
-    TileCollection remaining_tiles = this->collection;
-    std::vector<TileKind> tiles;
-    for (size_t i = 0; i < anchors.size(); i++) {
-        // call left on anchor spots with limit > 0
-        if (anchors[i].limit > 0) {
-            left_part(
-                    anchors[i].position,
-                    "",
-                    Move(tiles, anchors[i].position.row, anchors[i].position.column, anchors[i].direction),
-                    dictionary.get_root(),
-                    anchors[i].limit,
-                    remaining_tiles,
-                    legal_moves,
+// Index of a letter in SearchContext::counts and kinds, or -1 if no tile can stand for it
+static int rack_index(char letter) {
+    if (letter == TileKind::BLANK_LETTER) {
+        return 26;
+    }
+    if (letter < 'a' || letter > 'z') {
+        return -1;
+    }
+    return letter - 'a';
+}
+
+void ComputerPlayer::gaddag_extend(
+        const Board::Anchor& anchor,
+        Board::Position square,
+        Gaddag::Node node,
+        bool leftward,
+        SearchContext& search,
+        const Board& board,
+        const Gaddag& gaddag) const {
+    search.nodes++;
+    if (out_of_budget(search)) {
+        return;
+    }
+
+    // a tile already on the board has to become part of the word
+    if (board.in_bounds_and_has_tile(square)) {
+        Gaddag::Node next = gaddag.child(node, board.letter_at(square));
+        if (next != Gaddag::NONE) {
+            gaddag_advance(anchor, square, next, leftward, search, board, gaddag);
+        }
+        return;
+    }
+
+    const std::vector<uint32_t>& masks = search.cross_checks[anchor.direction == Direction::DOWN ? 1 : 0];
+    uint32_t allowed = masks[square.row * board.columns + square.column];
+    std::vector<TileKind>& placed = leftward ? search.left : search.right;
+
+    for (const Gaddag::Edge* edge = gaddag.edges_begin(node); edge != gaddag.edges_end(node); edge++) {
+        int index = rack_index(edge->letter);
+        if (index < 0 || index == 26 || !(allowed & (1u << index))) {
+            continue;
+        }
+        search.stats.rack_lookups += 2;
+        // check if player has blank tile
+        if (search.counts[26] > 0) {
+            TileKind add(search.kinds[26]);
+            add.assigned = edge->letter;
+            search.counts[26]--;
+            placed.push_back(add);
+            gaddag_advance(anchor, square, edge->target, leftward, search, board, gaddag);
+            // backtrack
+            placed.pop_back();
+            search.counts[26]++;
+        }
+        // check if player has specific tile
+        if (search.counts[index] > 0) {
+            search.counts[index]--;
+            placed.push_back(search.kinds[index]);
+            gaddag_advance(anchor, square, edge->target, leftward, search, board, gaddag);
+            // backtrack
+            placed.pop_back();
+            search.counts[index]++;
+        }
+    }
+}
+
+void ComputerPlayer::gaddag_advance(
+        const Board::Anchor& anchor,
+        Board::Position square,
+        Gaddag::Node node,
+        bool leftward,
+        SearchContext& search,
+        const Board& board,
+        const Gaddag& gaddag) const {
+    // records the word if it ends just before `after`
+    auto record_word = [&](Gaddag::Node end, Board::Position after) {
+        if (gaddag.is_final(end) && !board.in_bounds_and_has_tile(after)) {
+            record_placement(anchor, search, board);
+        }
+    };
+
+    if (!leftward) {
+        Board::Position after = square.translate(anchor.direction);
+        if (search.bounds != nullptr) {
+            Board::Position start = anchor.position.translate(anchor.direction, 1 - (ssize_t)search.left.size());
+            size_t bound = placement_bound(anchor.direction, start, after, search.left, search.right, search, board);
+            if (prune(bound, search)) {
+                return;
+            }
+        }
+        record_word(node, after);
+        if (board.is_in_bounds(after)) {
+            gaddag_extend(anchor, after, node, false, search, board, gaddag);
+        }
+        return;
+    }
+
+    Board::Position before = square.translate(anchor.direction, -1);
+    // the word cannot start right after a tile, so keep going left through it
+    if (board.in_bounds_and_has_tile(before)) {
+        gaddag_extend(anchor, before, node, true, search, board, gaddag);
+        return;
+    }
+
+    // the left part is done: cross the separator and continue to the right of the anchor
+    Gaddag::Node turn = gaddag.child(node, Gaddag::SEPARATOR);
+    if (turn != Gaddag::NONE) {
+        Board::Position after = anchor.position.translate(anchor.direction);
+        record_word(turn, after);
+        if (board.is_in_bounds(after)) {
+            gaddag_extend(anchor, after, turn, false, search, board, gaddag);
+        }
+    }
+
+    // or grow the left part by another rack tile, as far as the anchor's limit allows
+    if (board.is_in_bounds(before) && search.left.size() <= anchor.limit) {
+        gaddag_extend(anchor, before, node, true, search, board, gaddag);
+    }
+}
+
+void ComputerPlayer::compute_cross_checks(
+        Direction direction, const Board& board, const Dictionary& dictionary, std::vector<uint32_t>& masks) const {
+    const uint32_t all = (1u << 26) - 1;
+    masks.assign(board.rows * board.columns, all);
+
+    for (size_t row = 0; row < board.rows; row++) {
+        for (size_t column = 0; column < board.columns; column++) {
+            Board::Position square(row, column);
+            if (board.in_bounds_and_has_tile(square)) {
+                continue;
+            }
+            // the perpendicular word runs in the other direction
+            Direction across = !direction;
+            std::string before;
+            std::string after;
+            for (Board::Position p = square.translate(across, -1); board.in_bounds_and_has_tile(p);
+                 p = p.translate(across, -1)) {
+                before.insert(before.begin(), board.letter_at(p));
+            }
+            for (Board::Position p = square.translate(across); board.in_bounds_and_has_tile(p);
+                 p = p.translate(across)) {
+                after.push_back(board.letter_at(p));
+            }
+            if (before.empty() && after.empty()) {
+                continue;
+            }
+
+            uint32_t mask = 0;
+            std::shared_ptr<Dictionary::TrieNode> node = dictionary.find_prefix(before);
+            if (node != nullptr) {
+                for (auto it = node->nexts.begin(); it != node->nexts.end(); it++) {
+                    int index = rack_index(it->first);
+                    if (index < 0 || index == 26) {
+                        continue;
+                    }
+                    std::shared_ptr<Dictionary::TrieNode> cur = it->second;
+                    for (size_t i = 0; cur != nullptr && i < after.size(); i++) {
+                        auto next = cur->nexts.find(after[i]);
+                        cur = next == cur->nexts.end() ? nullptr : next->second;
+                    }
+                    if (cur != nullptr && cur->is_final) {
+                        mask |= 1u << index;
+                    }
+                }
+            }
+            masks[row * board.columns + column] = mask;
+        }
+    }
+}
+
+ComputerPlayer::SearchContext ComputerPlayer::make_context() const {
+    SearchContext search;
+    search.remaining_tiles = this->collection;
+    search.counts.assign(27, 0);
+    search.kinds.assign(27, TileKind('\0', 0));
+    for (auto it = this->collection.cbegin(); it != this->collection.cend(); ++it) {
+        int index = rack_index(it->letter);
+        if (index >= 0) {
+            search.counts[index]++;
+            search.kinds[index] = *it;
+        }
+    }
+    return search;
+}
+
+bool ComputerPlayer::out_of_budget(SearchContext& search) const {
+    Budget* budget = search.budget;
+    if (budget == nullptr) {
+        return false;
+    }
+    if (budget->stop != nullptr && budget->stop->load(std::memory_order_relaxed)) {
+        budget->exhausted.store(true, std::memory_order_relaxed);
+        return true;
+    }
+    if (budget->effort.anchor_nodes > 0 && search.nodes - search.anchor_start > budget->effort.anchor_nodes) {
+        budget->capped = true;
+        return true;
+    }
+    // looking at the clock and the shared counter on every node would cost more than the nodes themselves
+    if (search.nodes % BUDGET_CHECK_INTERVAL == 0) {
+        size_t spent = budget->spent.fetch_add(BUDGET_CHECK_INTERVAL, std::memory_order_relaxed)
+                       + BUDGET_CHECK_INTERVAL;
+        if ((budget->nodes > 0 && spent >= budget->nodes)
+            || (budget->timed && std::chrono::steady_clock::now() >= budget->deadline)) {
+            budget->exhausted.store(true, std::memory_order_relaxed);
+        }
+    }
+    return budget->exhausted.load(std::memory_order_relaxed);
+}
+
+size_t ComputerPlayer::anchor_priority(const Board::Anchor& anchor, const Board& board) const {
+    // walk every empty square a move through the anchor could cover: back as far as the limit and the rack allow,
+    // then forward until the rack would be used up
+    size_t tiles = this->count_tiles();
+    size_t reach = std::min(anchor.limit, tiles > 0 ? tiles - 1 : 0);
+    size_t letter_bonus = 0;
+    size_t word_multiplier = 1;
+    Board::Position square = anchor.position.translate(anchor.direction, -(ssize_t)reach);
+    for (size_t placed = 0; board.is_in_bounds(square) && placed < reach + tiles;
+         square = square.translate(anchor.direction)) {
+        const BoardSquare& board_square = board.square_at(square);
+        if (board_square.has_tile()) {
+            letter_bonus += board_square.get_tile_kind().points;
+            continue;
+        }
+        letter_bonus += board_square.letter_multiplier;
+        word_multiplier *= board_square.word_multiplier;
+        placed++;
+    }
+    return letter_bonus * word_multiplier;
+}
+
+void ComputerPlayer::compute_cross_sums(Direction direction, const Board& board, std::vector<int>& sums) const {
+    sums.assign(board.rows * board.columns, -1);
+    Direction across = !direction;
+    for (size_t row = 0; row < board.rows; row++) {
+        for (size_t column = 0; column < board.columns; column++) {
+            Board::Position square(row, column);
+            if (board.in_bounds_and_has_tile(square)) {
+                continue;
+            }
+            bool touching = false;
+            int sum = 0;
+            for (Board::Position p = square.translate(across, -1); board.in_bounds_and_has_tile(p);
+                 p = p.translate(across, -1)) {
+                sum += board.square_at(p).get_tile_kind().points;
+                touching = true;
+            }
+            for (Board::Position p = square.translate(across); board.in_bounds_and_has_tile(p);
+                 p = p.translate(across)) {
+                sum += board.square_at(p).get_tile_kind().points;
+                touching = true;
+            }
+            if (touching) {
+                sums[row * board.columns + column] = sum;
+            }
+        }
+    }
+}
+
+size_t ComputerPlayer::anchor_bound(
+        const Board::Anchor& anchor,
+        const Board& board,
+        const std::vector<int>& cross_sums,
+        const std::vector<uint32_t>* cross_checks) const {
+    std::vector<size_t> values;
+    uint32_t letters = 0;
+    for (auto it = this->collection.cbegin(); it != this->collection.cend(); ++it) {
+        values.push_back(it->points);
+        int index = rack_index(it->letter);
+        letters |= index == 26 ? (1u << 26) - 1 : index >= 0 ? 1u << index : 0;
+    }
+    if (values.empty()) {
+        return 0;
+    }
+    std::sort(values.begin(), values.end(), std::greater<size_t>());
+    // no tile on the rack fits a square whose cross checks rule out all of its letters, so no move covers it
+    auto playable = [&](Board::Position square) {
+        return cross_checks == nullptr || ((*cross_checks)[square.row * board.columns + square.column] & letters) != 0;
+    };
+
+    // the empty squares a move can cover on either side of the anchor, nearest first, and after each of them the
+    // points of the tiles on the board it brings into the word
+    std::vector<Board::Position> squares[2];
+    std::vector<size_t> runs[2] = {std::vector<size_t>(1, 0), std::vector<size_t>(1, 0)};
+    size_t reach[2] = {std::min(anchor.limit, values.size() - 1), values.size()};
+    for (size_t side = 0; side < 2; side++) {
+        Board::Position square = side == 0 ? anchor.position.translate(anchor.direction, -1) : anchor.position;
+        for (; board.is_in_bounds(square); square = square.translate(anchor.direction, side == 0 ? -1 : 1)) {
+            if (board.in_bounds_and_has_tile(square)) {
+                runs[side].back() += board.square_at(square).get_tile_kind().points;
+            } else if (squares[side].size() < reach[side] && playable(square)) {
+                squares[side].push_back(square);
+                runs[side].push_back(0);
+            } else {
+                break;
+            }
+        }
+    }
+
+    // shadow every span of empty squares through the anchor that the rack can fill, and keep the best
+    size_t best = 0;
+    for (size_t left = 0; left <= squares[0].size(); left++) {
+        for (size_t right = 1; right <= squares[1].size() && left + right <= values.size(); right++) {
+            size_t existing = 0;
+            size_t word_multiplier = 1;
+            for (size_t side = 0; side < 2; side++) {
+                size_t count = side == 0 ? left : right;
+                for (size_t i = 0; i < count; i++) {
+                    word_multiplier *= board.square_at(squares[side][i]).word_multiplier;
+                }
+                for (size_t i = 0; i <= count; i++) {
+                    existing += runs[side][i];
+                }
+            }
+
+            // a tile counts once in the main word and once more in any cross word it forms, so the best tiles go
+            // where they count the most
+            size_t points = existing * word_multiplier;
+            std::vector<size_t> weights;
+            for (size_t side = 0; side < 2; side++) {
+                size_t count = side == 0 ? left : right;
+                for (size_t i = 0; i < count; i++) {
+                    const BoardSquare& square = board.square_at(squares[side][i]);
+                    size_t weight = square.letter_multiplier * word_multiplier;
+                    int sum = cross_sums[squares[side][i].row * board.columns + squares[side][i].column];
+                    if (sum >= 0) {
+                        points += sum * square.word_multiplier;
+                        weight += square.letter_multiplier * square.word_multiplier;
+                    }
+                    weights.push_back(weight);
+                }
+            }
+            std::sort(weights.begin(), weights.end(), std::greater<size_t>());
+            for (size_t i = 0; i < weights.size(); i++) {
+                points += values[i] * weights[i];
+            }
+            best = std::max(best, points);
+        }
+    }
+    return best;
+}
+
+size_t ComputerPlayer::placement_bound(
+        Direction direction,
+        Board::Position start,
+        Board::Position next,
+        const std::vector<TileKind>& reversed,
+        const std::vector<TileKind>& forward,
+        const SearchContext& search,
+        const Board& board) const {
+    // the tiles still on the rack, best first
+    std::vector<size_t> values;
+    if (search.cross_checks != nullptr) {
+        for (size_t i = 0; i < search.counts.size(); i++) {
+            values.insert(values.end(), search.counts[i], search.kinds[i].points);
+        }
+    } else {
+        for (auto it = search.remaining_tiles.cbegin(); it != search.remaining_tiles.cend(); ++it) {
+            values.push_back(it->points);
+        }
+    }
+    std::sort(values.begin(), values.end(), std::greater<size_t>());
+    const std::vector<int>& cross_sums = search.bounds->cross_sums[direction == Direction::DOWN ? 1 : 0];
+
+    size_t letters = 0;
+    size_t word_multiplier = 1;
+    size_t cross = 0;
+    std::vector<size_t> letter_multipliers;
+    auto reach = [&](Board::Position p) {
+        const BoardSquare& square = board.square_at(p);
+        letter_multipliers.push_back(square.letter_multiplier);
+        word_multiplier *= square.word_multiplier;
+        int sum = cross_sums[p.row * board.columns + p.column];
+        if (sum >= 0) {
+            cross += (sum + values[0] * square.letter_multiplier) * square.word_multiplier;
+        }
+    };
+
+    // the word takes in any tiles right before its first placed tile
+    for (Board::Position p = start.translate(direction, -1); board.in_bounds_and_has_tile(p);
+         p = p.translate(direction, -1)) {
+        letters += board.square_at(p).get_tile_kind().points;
+    }
+
+    // the part that is already known scores exactly
+    size_t placed = 0;
+    for (Board::Position p = start; !(p == next); p = p.translate(direction)) {
+        const BoardSquare& square = board.square_at(p);
+        if (square.has_tile()) {
+            letters += square.get_tile_kind().points;
+            continue;
+        }
+        size_t points = placed < reversed.size() ? reversed[reversed.size() - 1 - placed].points
+                                                 : forward[placed - reversed.size()].points;
+        placed++;
+        letters += points * square.letter_multiplier;
+        word_multiplier *= square.word_multiplier;
+        int sum = cross_sums[p.row * board.columns + p.column];
+        if (sum >= 0) {
+            cross += (sum + points * square.letter_multiplier) * square.word_multiplier;
+        }
+    }
+
+    // the rest of the rack can only go on the empty squares from next on
+    size_t reached = 0;
+    for (Board::Position p = next; board.is_in_bounds(p); p = p.translate(direction)) {
+        if (board.in_bounds_and_has_tile(p)) {
+            letters += board.square_at(p).get_tile_kind().points;
+        } else if (reached < values.size()) {
+            reach(p);
+            reached++;
+        } else {
+            break;
+        }
+    }
+
+    // the best tiles left on the best letter multipliers
+    std::sort(letter_multipliers.begin(), letter_multipliers.end(), std::greater<size_t>());
+    for (size_t i = 0; i < values.size() && i < letter_multipliers.size(); i++) {
+        letters += values[i] * letter_multipliers[i];
+    }
+    return letters * word_multiplier + cross;
+}
+
+bool ComputerPlayer::prune(size_t bound, SearchContext& search) const {
+    if (bound + search.bounds->leave >= search.bounds->best.load(std::memory_order_relaxed)) {
+        return false;
+    }
+    search.bounds->pruned[search.anchor] = true;
+    return true;
+}
+
+void ComputerPlayer::record(SearchContext& search, const Move& move, const Board& board) const {
+    if (move.tiles.size() == 1) {
+        Board::Position square(move.row, move.column);
+        bool across_neighbour = board.in_bounds_and_has_tile(square.translate(Direction::ACROSS, -1))
+                                || board.in_bounds_and_has_tile(square.translate(Direction::ACROSS));
+        if ((move.direction == Direction::DOWN) == across_neighbour) {
+            search.duplicates++;
+            return;
+        }
+    }
+    if (search.prune_blanks) {
+        for (const TileKind& tile : move.tiles) {
+            if (tile.letter != TileKind::BLANK_LETTER) {
+                continue;
+            }
+            size_t real = search.cross_checks != nullptr
+                                  ? search.counts[rack_index(tile.assigned)]
+                                  : search.remaining_tiles.count_tiles(TileKind(tile.assigned, 0));
+            if (real > 0) {
+                return;
+            }
+        }
+    }
+    search.stats.candidates++;
+    search.visit(search, move);
+    search.order++;
+}
+
+void ComputerPlayer::record_placement(const Board::Anchor& anchor, SearchContext& search, const Board& board) const {
+    Board::Position first = anchor.position.translate(anchor.direction, 1 - (ssize_t)search.left.size());
+    Move& move = search.placement;
+    move.kind = MoveKind::PLACE;
+    move.row = first.row;
+    move.column = first.column;
+    move.direction = anchor.direction;
+    move.tiles.assign(search.left.rbegin(), search.left.rend());
+    move.tiles.insert(move.tiles.end(), search.right.begin(), search.right.end());
+    record(search, move, board);
+}
+
+void ComputerPlayer::search_anchor(
+        const Board::Anchor& anchor, SearchContext& search, const Board& board, const Dictionary& dictionary) const {
+    if (search.cross_checks != nullptr) {
+        gaddag_extend(anchor, anchor.position, dictionary.get_gaddag()->root(), true, search, board,
+                      *dictionary.get_gaddag());
+        return;
+    }
+
+    Move placement(std::vector<TileKind>(), anchor.position.row, anchor.position.column, anchor.direction);
+    // call left on anchor spots with limit > 0
+    if (anchor.limit > 0) {
+        left_part(
+                anchor.position,
+                "",
+                placement,
+                dictionary.get_root(),
+                anchor.limit,
+                search,
+                board);
+        // call extend right on anchor spots with limit = 0
+    } else if (anchor.limit == 0) {
+        std::string partial = "";
+        Board::Position p = anchor.position;
+        p = p.translate(anchor.direction, -1);
+        // build the partial word to the left or above the anchor spot with
+        // the tiles already placed
+        while (board.in_bounds_and_has_tile(p)) {
+            partial = board.letter_at(p) + partial;
+            p = p.translate(anchor.direction, -1);
+        }
+        // make sure the partial word has a prefix
+        if (dictionary.find_prefix(partial) != nullptr) {
+            extend_right(
+                    anchor.position,
+                    partial,
+                    placement,
+                    dictionary.find_prefix(partial),
+                    search,
                     board);
-            // call extend right on anchor spots with limit = 0
-        } else if (anchors[i].limit == 0) {
-            std::string partial = "";
-            Board::Position p = anchors[i].position;
-            p = p.translate(anchors[i].direction, -1);
-            // build the partial word to the left or above the anchor spot with
-            // the tiles already placed
-            while (board.in_bounds_and_has_tile(p)) {
-                partial = board.letter_at(p) + partial;
-                p = p.translate(anchors[i].direction, -1);
-            }
-            // make sure the partial word has a prefix
-            if (dictionary.find_prefix(partial) != nullptr) {
-                extend_right(
-                        anchors[i].position,
-                        partial,
-                        Move(tiles, anchors[i].position.row, anchors[i].position.column, anchors[i].direction),
-                        dictionary.find_prefix(partial),
-                        remaining_tiles,
-                        legal_moves,
-                        board);
+        }
+    }
+}
+
+std::vector<ComputerPlayer::SearchContext> ComputerPlayer::search_anchors(
+        const Board& board,
+        const Dictionary& dictionary,
+        const std::vector<Board::Anchor>& anchors,
+        const std::function<void(SearchContext&, const Move&)>& visit,
+        bool budgeted,
+        Bounds* bounds,
+        bool prune_blanks) const {
+    auto start = std::chrono::steady_clock::now();
+    Budget budget;
+    budgeted = budgeted && (time_budget.count() > 0 || node_budget > 0 || effort.capped());
+    if (budgeted) {
+        budget.timed = time_budget.count() > 0;
+        budget.deadline = std::chrono::steady_clock::now() + time_budget;
+        budget.nodes = node_budget;
+        budget.effort = effort;
+    }
+    budget.stop = interrupt;
+    bool limited = budgeted || interrupt != nullptr;
+
+    // the cross checks only depend on the board, so every worker shares them; the bounds use them with either engine
+    std::vector<uint32_t> cross_checks[2];
+    bool use_gaddag = engine == Engine::GADDAG && dictionary.get_gaddag() != nullptr;
+    if (use_gaddag || bounds != nullptr) {
+        compute_cross_checks(Direction::ACROSS, board, dictionary, cross_checks[0]);
+        compute_cross_checks(Direction::DOWN, board, dictionary, cross_checks[1]);
+    }
+
+    // a capped search stops at moves it finds, so it has to find them in the same order every time
+    size_t workers = pool == nullptr || budget.effort.capped() ? 1 : pool->size();
+    std::vector<SearchContext> contexts(workers, make_context());
+    for (size_t i = 0; i < contexts.size(); i++) {
+        contexts[i].cross_checks = use_gaddag ? cross_checks : nullptr;
+        contexts[i].visit = visit;
+        contexts[i].budget = limited ? &budget : nullptr;
+        contexts[i].bounds = bounds;
+        contexts[i].prune_blanks = prune_blanks;
+    }
+    std::vector<size_t> anchor_bounds;
+    if (bounds != nullptr) {
+        compute_cross_sums(Direction::ACROSS, board, bounds->cross_sums[0]);
+        compute_cross_sums(Direction::DOWN, board, bounds->cross_sums[1]);
+        bounds->pruned.assign(anchors.size(), false);
+        for (size_t i = 0; i < anchors.size(); i++) {
+            size_t d = anchors[i].direction == Direction::DOWN ? 1 : 0;
+            anchor_bounds.push_back(
+                    anchor_bound(anchors[i], board, bounds->cross_sums[d], &cross_checks[d]));
+        }
+    }
+
+    // the order the anchors are searched in; ties are broken by where the anchor is on the board,
+    // so the result of a search that finishes does not depend on this order
+    std::vector<size_t> order(anchors.size());
+    for (size_t i = 0; i < order.size(); i++) {
+        order[i] = i;
+    }
+    if (bounds != nullptr) {
+        std::stable_sort(order.begin(), order.end(), [&anchor_bounds](size_t a, size_t b) {
+            return anchor_bounds[a] > anchor_bounds[b];
+        });
+    } else if (budgeted) {
+        std::vector<size_t> priorities(anchors.size());
+        for (size_t i = 0; i < anchors.size(); i++) {
+            priorities[i] = anchor_priority(anchors[i], board);
+        }
+        std::stable_sort(order.begin(), order.end(), [&priorities](size_t a, size_t b) {
+            return priorities[a] > priorities[b];
+        });
+    }
+
+    auto prepared = std::chrono::steady_clock::now();
+    search_stats.prepare_time += prepared - start;
+
+    // returns false for an anchor skipped because of its bound
+    std::atomic<size_t> skipped{0};
+    auto run = [&](size_t index, SearchContext& search) {
+        if (limited && budget.exhausted.load(std::memory_order_relaxed)) {
+            return true;
+        }
+        search.anchor = index;
+        search.order = 0;
+        if (bounds != nullptr && prune(anchor_bounds[index], search)) {
+            skipped++;
+            return false;
+        }
+        search.stats.anchors++;
+        search.anchor_start = search.nodes;
+        search_anchor(anchors[index], search, board, dictionary);
+        if (budget.effort.greedy && budget.found) {
+            budget.exhausted = true;
+        }
+        return true;
+    };
+    if (contexts.size() == 1) {
+        for (size_t i = 0; i < order.size(); i++) {
+            if (!run(order[i], contexts[0])) {
+                // the anchors are in order of their bounds, so none of the rest can beat the best move either
+                for (size_t j = i + 1; j < order.size(); j++) {
+                    bounds->pruned[order[j]] = true;
+                }
+                skipped += order.size() - i - 1;
+                break;
+            }
+        }
+    } else if (budgeted || bounds != nullptr) {
+        // the pool hands every worker a block of its own, but the best anchors should go first on all of them,
+        // so each task just takes the next anchor in priority order
+        std::atomic<size_t> next{0};
+        pool->run(order.size(), [&](size_t worker, size_t) { run(order[next++], contexts[worker]); });
+    } else {
+        pool->run(anchors.size(), [&](size_t worker, size_t index) { run(index, contexts[worker]); });
+    }
+
+    search_stats.search_time += std::chrono::steady_clock::now() - prepared;
+    nodes_visited = 0;
+    duplicates_avoided = 0;
+    anchors_skipped = skipped;
+    for (size_t i = 0; i < contexts.size(); i++) {
+        contexts[i].cross_checks = nullptr;
+        contexts[i].visit = nullptr;
+        contexts[i].budget = nullptr;
+        contexts[i].bounds = nullptr;
+        nodes_visited += contexts[i].nodes;
+        duplicates_avoided += contexts[i].duplicates;
+        const SearchStats& worker = contexts[i].stats;
+        search_stats.anchors += worker.anchors;
+        search_stats.rack_lookups += worker.rack_lookups;
+        search_stats.candidates += worker.candidates;
+        search_stats.placements_tested += worker.placements_tested;
+        search_stats.word_checks += worker.word_checks;
+        search_stats.words_rejected += worker.words_rejected;
+        search_stats.scoring_time += worker.scoring_time;
+    }
+    search_stats.nodes += nodes_visited;
+    search_stats.duplicates += duplicates_avoided;
+    search_stats.anchors_skipped += anchors_skipped;
+    search_complete = !budget.exhausted && !budget.capped;
+    return contexts;
+}
+
+bool ComputerPlayer::ranks_before(const Candidate& a, const Candidate& b) {
+    if (a.ranked.equity != b.ranked.equity) {
+        return a.ranked.equity > b.ranked.equity;
+    }
+    if (a.anchor != b.anchor) {
+        return a.anchor < b.anchor;
+    }
+    return a.order < b.order;
+}
+
+void ComputerPlayer::offer(
+        std::vector<Candidate>& heap,
+        size_t keep,
+        const Move& move,
+        PlaceResult& result,
+        double equity,
+        size_t anchor,
+        size_t order) {
+    if (keep == 0) {
+        return;
+    }
+    // the heap is ordered so that its front is the worst move kept, which is the one a better move replaces
+    if (heap.size() == keep) {
+        const Candidate& worst = heap.front();
+        // moves come in generation order, so a tie with the worst kept move never beats it
+        if (equity < worst.ranked.equity || (equity == worst.ranked.equity && anchor >= worst.anchor)) {
+            return;
+        }
+        std::pop_heap(heap.begin(), heap.end(), ranks_before);
+        heap.pop_back();
+    }
+    heap.push_back(Candidate{RankedMove{move, result.points, std::move(result.words), equity}, anchor, order});
+    std::push_heap(heap.begin(), heap.end(), ranks_before);
+}
+
+size_t ComputerPlayer::anchor_rank(const Board::Anchor& anchor, const Board& board) {
+    return (anchor.position.row * board.columns + anchor.position.column) * 2
+           + (anchor.direction == Direction::DOWN ? 1 : 0);
+}
+
+std::string ComputerPlayer::rack_key() const {
+    std::vector<std::string> tiles;
+    for (auto it = this->collection.cbegin(); it != this->collection.cend(); ++it) {
+        tiles.push_back(std::string(1, it->letter) + std::to_string(it->points));
+    }
+    std::sort(tiles.begin(), tiles.end());
+    std::string key;
+    for (size_t i = 0; i < tiles.size(); i++) {
+        key += tiles[i] + ' ';
+    }
+    return key;
+}
+
+Move ComputerPlayer::get_move(const Board& board, const Dictionary& dictionary) const {
+    stop_pondering();
+    // what the player pondered with a different dictionary or different settings no longer applies
+    bool pondered = pondering != nullptr && pondering->context == ponder_context(board, dictionary);
+    // the lines pondering searched hold for this board too where the opponent's move left them alone
+    if (pondered && pondering->warmed) {
+        for (size_t d = 0; d < 2; d++) {
+            line_cache[d] = std::move(pondering->thinker->line_cache[d]);
+        }
+        cached_dictionary = &dictionary;
+        pondering->warmed = false;
+    }
+    auto start = std::chrono::steady_clock::now();
+    search_stats = SearchStats();
+    ponder_hit = false;
+    Move move;
+    if (pondered && picks_by_equity(unseen_in_bag)) {
+        auto found = pondering->answers.find(board.get_hash());
+        if (found != pondering->answers.end() && found->second.rack == rack_key()
+            && found->second.in_bag == unseen_in_bag) {
+            ponder_hit = true;
+            nodes_visited = 0;
+            move = found->second.move.to_move();
+            search_stats.lookup_time = std::chrono::steady_clock::now() - start;
+        }
+    }
+    if (!ponder_hit) {
+        move = choose_move(board, dictionary, unseen_in_bag);
+    }
+    search_stats.total_time = std::chrono::steady_clock::now() - start;
+
+    if (search_log != nullptr) {
+        auto ms = [](std::chrono::nanoseconds time) { return std::chrono::duration<double, std::milli>(time).count(); };
+        const SearchStats& stats = search_stats;
+        *search_log << get_name() << ": " << ms(stats.total_time) << " ms, " << stats.anchors << " anchors ("
+                    << stats.anchors_skipped << " skipped), " << stats.nodes << " nodes, " << stats.rack_lookups
+                    << " rack lookups, " << stats.candidates << " candidates (" << stats.duplicates
+                    << " duplicates), " << stats.placements_tested << " placements tested, " << stats.word_checks
+                    << " word checks (" << stats.words_rejected << " rejected); lookup " << ms(stats.lookup_time)
+                    << " ms, prepare " << ms(stats.prepare_time) << " ms, search " << ms(stats.search_time)
+                    << " ms, scoring " << ms(stats.scoring_time) << " ms" << std::endl;
+    }
+    return move;
+}
+
+bool ComputerPlayer::picks_by_equity(size_t in_bag) const {
+    if (strategy != nullptr) {
+        return false;
+    }
+    if (effort.capped()) {
+        return true;
+    }
+    if (simulation_candidates > 0 || lookahead_candidates > 0) {
+        return false;
+    }
+    return endgame_time.count() == 0 || in_bag > PRE_ENDGAME_BAG || (in_bag == 0 && unseen_tiles.empty());
+}
+
+Move ComputerPlayer::choose_move(const Board& board, const Dictionary& dictionary, size_t in_bag) const {
+    if (strategy != nullptr) {
+        Move move = strategy->choose_move(*this, board, dictionary);
+        // a strategy that picked with the chooser searched on this player's behalf
+        if (chooser != nullptr) {
+            search_stats = chooser->search_stats;
+            nodes_visited = chooser->nodes_visited;
+            search_complete = chooser->search_complete;
+        }
+        return move;
+    }
+    bool capped = effort.capped();
+    if (!capped && endgame_time.count() > 0 && in_bag == 0 && !unseen_tiles.empty()) {
+        EndgameSolver solver(dictionary, engine, get_hand_size());
+        EndgameSolver::Result result = solver.solve(board, get_tiles(), unseen_tiles, endgame_time);
+        if (!result.sequence.empty()) {
+            return result.sequence[0];
+        }
+    }
+
+    RankedMove best{Move(), 0, std::vector<std::string>(), 0};
+    bool pre_endgame = endgame_time.count() > 0 && in_bag > 0 && in_bag <= PRE_ENDGAME_BAG;
+    if (!capped && (pre_endgame || simulation_candidates > 0 || lookahead_candidates > 0)) {
+        std::vector<SimulatedMove> simulated = pre_endgame                ? solve_pre_endgame(board, dictionary)
+                                               : simulation_candidates > 0 ? simulate(board, dictionary)
+                                                                           : look_ahead(board, dictionary);
+        size_t chosen = 0;
+        for (size_t i = 1; i < simulated.size(); i++) {
+            if (simulated[i].average > simulated[chosen].average) {
+                chosen = i;
             }
         }
+        if (!simulated.empty()) {
+            best = simulated[chosen].ranked;
+        }
+    } else {
+        std::vector<RankedMove> top = get_top_moves(board, dictionary, 1);
+        if (!top.empty()) {
+            best = top[0];
+        }
+    }
+    // a move that scores nothing is no better than passing, which keeps the whole rack
+    if (best.points == 0) {
+        best = RankedMove{Move(), 0, std::vector<std::string>(), leave_value(get_tiles())};
+    }
+    // exchanging takes a full rack of tiles left in the bag
+    if (leaves != nullptr && in_bag >= get_hand_size()) {
+        RankedMove exchange = get_best_exchange();
+        if (exchange.equity > best.equity) {
+            return exchange.move;
+        }
+    }
+    return best.move;
+}
+
+ComputerPlayer::RankedMove ComputerPlayer::get_best_exchange() const {
+    RankedMove best{Move(), 0, std::vector<std::string>(), -std::numeric_limits<double>::infinity()};
+    std::vector<TileKind> rack = get_tiles();
+    if (leaves == nullptr || rack.empty()) {
+        return best;
+    }
+
+    // the distinct tiles of the rack, with how many of each there are
+    std::vector<TileKind> kinds;
+    std::vector<size_t> available;
+    std::vector<int> indices;
+    for (const TileKind& tile : rack) {
+        if (kinds.empty() || kinds.back().letter != tile.letter) {
+            kinds.push_back(tile);
+            available.push_back(0);
+            indices.push_back(LeaveTable::tile_index(tile.letter));
+        }
+        available.back()++;
     }
 
-    return get_best_move(legal_moves, board, dictionary);
+    // count every leave like a mixed-radix number, one digit per distinct tile, starting from the empty leave
+    size_t counts[LeaveTable::TILE_KINDS] = {};
+    std::vector<size_t> keep(kinds.size(), 0);
+    size_t kept = 0;
+    while (kept < rack.size()) {
+        double value = leaves->value(counts);
+        if (value > best.equity) {
+            std::vector<TileKind> exchanged;
+            for (size_t k = 0; k < kinds.size(); k++) {
+                exchanged.insert(exchanged.end(), available[k] - keep[k], kinds[k]);
+            }
+            best = RankedMove{Move(exchanged), 0, std::vector<std::string>(), value};
+        }
+        size_t k = 0;
+        while (k < kinds.size() && keep[k] == available[k]) {
+            kept -= keep[k];
+            if (indices[k] >= 0) {
+                counts[indices[k]] -= keep[k];
+            }
+            keep[k] = 0;
+            k++;
+        }
+        if (k == kinds.size()) {
+            break;
+        }
+        keep[k]++;
+        kept++;
+        if (indices[k] >= 0) {
+            counts[indices[k]]++;
+        }
+    }
+    return best;
 }
 
-Move ComputerPlayer::get_best_move(
-        std::vector<Move> legal_moves, const Board& board, const Dictionary& dictionary) const {
-    Move best_move = Move();  // Pass if no move found
-    size_t highest = 0;
-    int index = -1;
-    bool valid;
+std::vector<ComputerPlayer::SimulatedMove>
+ComputerPlayer::simulate(const Board& board, const Dictionary& dictionary) const {
+    auto start = std::chrono::steady_clock::now();
+    std::vector<RankedMove> candidates = get_top_moves(board, dictionary, simulation_candidates);
+    if (candidates.empty()) {
+        return std::vector<SimulatedMove>();
+    }
+
+    // scratch players for both sides on every worker, searching on their own threads
+    ComputerPlayer scratch(get_name(), get_hand_size());
+    scratch.set_engine(engine);
+    scratch.set_leave_table(leaves);
+    scratch.set_effort(playout_effort);
+    size_t workers = pool == nullptr ? 1 : pool->size();
+    std::vector<ComputerPlayer> sides(workers * 2, scratch);
 
-    for (size_t i = 0; i < legal_moves.size(); i++) {
-        valid = true;
-        if (legal_moves[i].tiles.size() == 0) {
+    // one row of outcomes per iteration, summed in order at the end so the thread count cannot change the averages
+    std::vector<double> outcomes(simulation_iterations * candidates.size());
+    std::vector<char> finished(simulation_iterations, false);
+    auto deadline = start + time_budget;
+    auto run = [&](size_t worker, size_t iteration) {
+        if (time_budget.count() > 0 && std::chrono::steady_clock::now() >= deadline) {
+            return;
+        }
+        std::seed_seq seed{simulation_seed, static_cast<uint32_t>(iteration)};
+        std::mt19937 random(seed);
+        std::vector<TileKind> draws = unseen_tiles;
+        std::shuffle(draws.begin(), draws.end(), random);
+        for (size_t i = 0; i < candidates.size(); i++) {
+            outcomes[iteration * candidates.size() + i]
+                    = playout(candidates[i], draws, board, dictionary, sides[worker * 2], sides[worker * 2 + 1]);
+        }
+        finished[iteration] = true;
+    };
+    if (pool == nullptr) {
+        for (size_t i = 0; i < simulation_iterations; i++) {
+            run(0, i);
+        }
+    } else {
+        pool->run(simulation_iterations, run);
+    }
+
+    std::vector<SimulatedMove> results;
+    for (size_t i = 0; i < candidates.size(); i++) {
+        results.push_back(SimulatedMove{candidates[i], 0});
+    }
+    size_t iterations = 0;
+    for (size_t iteration = 0; iteration < simulation_iterations; iteration++) {
+        if (!finished[iteration]) {
             continue;
         }
-        PlaceResult result = board.test_place(legal_moves[i]);
+        iterations++;
+        for (size_t i = 0; i < candidates.size(); i++) {
+            results[i].average += outcomes[iteration * candidates.size() + i];
+        }
+    }
+    // without a single playout the static equity is the best guess
+    for (size_t i = 0; i < results.size(); i++) {
+        results[i].average = iterations == 0 ? results[i].ranked.equity : results[i].average / iterations;
+    }
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    playouts_per_second = seconds > 0 ? iterations * candidates.size() / seconds : 0;
+    return results;
+}
+
+std::vector<ComputerPlayer::SimulatedMove>
+ComputerPlayer::solve_pre_endgame(const Board& board, const Dictionary& dictionary) const {
+    auto deadline = std::chrono::steady_clock::now() + endgame_time;
+    std::vector<RankedMove> candidates = get_top_moves(board, dictionary, PRE_ENDGAME_CANDIDATES);
+    pre_endgame_coverage = 0;
+    if (candidates.empty()) {
+        return std::vector<SimulatedMove>();
+    }
+
+    auto without = [](std::vector<TileKind> tiles, const std::vector<TileKind>& removed) {
+        for (const TileKind& tile : removed) {
+            for (size_t i = 0; i < tiles.size(); i++) {
+                if (tiles[i].letter == tile.letter) {
+                    tiles.erase(tiles.begin() + i);
+                    break;
+                }
+            }
+        }
+        return tiles;
+    };
+
+    // our draw, the rest of the bag, and the opponent's rack
+    struct World {
+        std::vector<TileKind> draw;
+        std::vector<TileKind> bag;
+        std::vector<TileKind> opponent;
+        double weight;
+    };
+    std::vector<std::vector<World>> worlds(candidates.size());
+    size_t most_worlds = 0;
+    for (size_t c = 0; c < candidates.size(); c++) {
+        size_t drawn = std::min(candidates[c].move.tiles.size(), unseen_in_bag);
+        for (const auto& draw : distinct_draws(unseen_tiles, drawn)) {
+            std::vector<TileKind> rest = without(unseen_tiles, draw.first);
+            for (const auto& bag : distinct_draws(rest, unseen_in_bag - drawn)) {
+                worlds[c].push_back(World{draw.first, bag.first, without(rest, bag.first), draw.second * bag.second});
+            }
+        }
+        std::stable_sort(worlds[c].begin(), worlds[c].end(), [](const World& a, const World& b) {
+            return a.weight > b.weight;
+        });
+        most_worlds = std::max(most_worlds, worlds[c].size());
+    }
+
+    // the most likely worlds first, one per candidate in turn, so running out of time treats every candidate alike
+    std::vector<std::pair<size_t, size_t>> tasks;
+    for (size_t w = 0; w < most_worlds; w++) {
+        for (size_t c = 0; c < candidates.size(); c++) {
+            if (w < worlds[c].size()) {
+                tasks.push_back(std::make_pair(c, w));
+            }
+        }
+    }
+
+    size_t workers = pool == nullptr ? 1 : pool->size();
+    auto table = std::make_shared<EndgameSolver::Table>();
+    std::vector<EndgameSolver> solvers(workers, EndgameSolver(dictionary, engine, get_hand_size(), table));
+    std::vector<double> outcomes(tasks.size());
+    std::vector<char> finished(tasks.size(), false);
+    std::vector<TileKind> rack = get_tiles();
+    auto run = [&](size_t worker, size_t task) {
+        auto left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now());
+        if (left.count() <= 0) {
+            return;
+        }
+        const RankedMove& candidate = candidates[tasks[task].first];
+        const World& world = worlds[tasks[task].first][tasks[task].second];
+        Board position = board;
+        position.place(candidate.move);
+        std::vector<TileKind> mine = without(rack, candidate.move.tiles);
+        mine.insert(mine.end(), world.draw.begin(), world.draw.end());
+        // the opponent moves next, so their best spread is our loss
+        EndgameSolver::Result result = solvers[worker].solve(position, world.opponent, mine, left, world.bag);
+        double bonus = candidate.move.tiles.size() == get_hand_size() ? BINGO_BONUS : 0;
+        outcomes[task] = candidate.points + bonus - result.spread;
+        finished[task] = true;
+    };
+    if (pool == nullptr) {
+        for (size_t i = 0; i < tasks.size(); i++) {
+            run(0, i);
+        }
+    } else {
+        pool->run(tasks.size(), run);
+    }
+
+    std::vector<SimulatedMove> results;
+    std::vector<double> covered(candidates.size(), 0);
+    for (size_t i = 0; i < candidates.size(); i++) {
+        results.push_back(SimulatedMove{candidates[i], 0});
+    }
+    for (size_t i = 0; i < tasks.size(); i++) {
+        if (finished[i]) {
+            double weight = worlds[tasks[i].first][tasks[i].second].weight;
+            results[tasks[i].first].average += weight * outcomes[i];
+            covered[tasks[i].first] += weight;
+        }
+    }
+    pre_endgame_coverage = 1;
+    for (size_t i = 0; i < results.size(); i++) {
+        // without a single world solved the static equity is the best guess
+        results[i].average = covered[i] > 0 ? results[i].average / covered[i] : results[i].ranked.equity;
+        pre_endgame_coverage = std::min(pre_endgame_coverage, covered[i]);
+    }
+    return results;
+}
+
+std::vector<std::pair<std::vector<TileKind>, double>>
+ComputerPlayer::distinct_draws(const std::vector<TileKind>& tiles, size_t count) {
+    // one kind per letter, with how many of it there are
+    std::vector<TileKind> kinds;
+    std::vector<size_t> available;
+    for (const TileKind& tile : tiles) {
+        size_t k = 0;
+        while (k < kinds.size() && kinds[k].letter != tile.letter) {
+            k++;
+        }
+        if (k == kinds.size()) {
+            kinds.push_back(tile);
+            available.push_back(0);
+        }
+        available[k]++;
+    }
+    auto choose = [](size_t n, size_t k) {
+        double result = 1;
+        for (size_t i = 1; i <= k; i++) {
+            result = result * (n - k + i) / i;
+        }
+        return result;
+    };
+
+    // hypergeometric: the ways to pick this draw over the ways to pick any count tiles
+    std::vector<std::pair<std::vector<TileKind>, double>> draws;
+    double all = choose(tiles.size(), count);
+    std::vector<TileKind> draw;
+    std::function<void(size_t, size_t, double)> pick = [&](size_t k, size_t left, double ways) {
+        if (left == 0) {
+            draws.push_back(std::make_pair(draw, ways / all));
+            return;
+        }
+        if (k == kinds.size()) {
+            return;
+        }
+        for (size_t n = std::min(left, available[k]) + 1; n-- > 0;) {
+            draw.insert(draw.end(), n, kinds[k]);
+            pick(k + 1, left - n, ways * choose(available[k], n));
+            draw.erase(draw.end() - n, draw.end());
+        }
+    };
+    if (count <= tiles.size()) {
+        pick(0, count, 1);
+    }
+    return draws;
+}
+
+std::vector<ComputerPlayer::SimulatedMove>
+ComputerPlayer::look_ahead(const Board& board, const Dictionary& dictionary) const {
+    auto deadline = std::chrono::steady_clock::now() + lookahead_time;
+    std::vector<RankedMove> candidates = get_top_moves(board, dictionary, lookahead_candidates);
+    std::vector<SimulatedMove> results;
+    for (size_t i = 0; i < candidates.size(); i++) {
+        results.push_back(SimulatedMove{candidates[i], candidates[i].equity});
+    }
+    lookahead_coverage = 1;
+    if (candidates.empty() || unseen_tiles.empty() || lookahead_samples == 0) {
+        return results;
+    }
+
+    // every worker places the candidates on its own board and searches the replies with its own opponent
+    size_t hand_size = get_hand_size();
+    size_t workers = pool == nullptr ? 1 : pool->size();
+    ComputerPlayer scratch("opponent", hand_size);
+    scratch.set_engine(engine);
+    std::vector<ComputerPlayer> opponents(workers, scratch);
+    std::vector<Board> boards(workers, board);
+
+    std::vector<double> replies(lookahead_samples * candidates.size());
+    std::vector<char> finished(replies.size(), false);
+    auto run = [&](size_t worker, size_t index) {
+        if (lookahead_time.count() > 0 && std::chrono::steady_clock::now() >= deadline) {
+            return;
+        }
+        size_t sample = index / candidates.size();
+        const RankedMove& candidate = candidates[index % candidates.size()];
+        std::seed_seq seed{lookahead_seed, static_cast<uint32_t>(sample)};
+        std::mt19937 random(seed);
+        std::vector<TileKind> draws = unseen_tiles;
+        std::shuffle(draws.begin(), draws.end(), random);
+        draws.erase(draws.begin() + std::min(hand_size, draws.size()), draws.end());
+
+        ComputerPlayer& opponent = opponents[worker];
+        opponent.remove_tiles(opponent.get_tiles());
+        opponent.add_tiles(draws);
+        Board& position = boards[worker];
+        bool placed = candidate.move.kind == MoveKind::PLACE && position.place(candidate.move).valid;
+        std::vector<RankedMove> reply = opponent.get_top_moves(position, dictionary, 1);
+        if (placed) {
+            position.undo_place();
+        }
+        if (!reply.empty()) {
+            replies[index] = reply[0].points + (reply[0].move.tiles.size() == hand_size ? BINGO_BONUS : 0);
+        }
+        finished[index] = true;
+    };
+    if (pool == nullptr) {
+        for (size_t i = 0; i < replies.size(); i++) {
+            run(0, i);
+        }
+    } else {
+        pool->run(replies.size(), run);
+    }
+
+    // with no sample finished at all the equity is the best guess
+    if (std::find(finished.begin(), finished.end(), true) == finished.end()) {
+        lookahead_coverage = 0;
+        return results;
+    }
+    for (size_t c = 0; c < candidates.size(); c++) {
+        size_t samples = 0;
+        double total = 0;
+        for (size_t sample = 0; sample < lookahead_samples; sample++) {
+            if (finished[sample * candidates.size() + c]) {
+                samples++;
+                total += replies[sample * candidates.size() + c];
+            }
+        }
+        results[c].average = samples == 0 ? -std::numeric_limits<double>::infinity()
+                                          : candidates[c].equity - total / samples;
+        lookahead_coverage = std::min(lookahead_coverage, static_cast<double>(samples) / lookahead_samples);
+    }
+    return results;
+}
+
+double ComputerPlayer::playout(
+        const RankedMove& candidate,
+        const std::vector<TileKind>& pool,
+        const Board& board,
+        const Dictionary& dictionary,
+        ComputerPlayer& me,
+        ComputerPlayer& opponent) const {
+    size_t hand_size = get_hand_size();
+    size_t next = 0;
+    auto draw = [&](ComputerPlayer& player, size_t count) {
+        count = std::min(count, pool.size() - next);
+        player.add_tiles(std::vector<TileKind>(pool.begin() + next, pool.begin() + next + count));
+        next += count;
+    };
+    auto bonus = [hand_size](const Move& move) { return move.tiles.size() == hand_size ? BINGO_BONUS : 0; };
+
+    Board position = board;
+    position.place(candidate.move);
+    double outcome = candidate.points + bonus(candidate.move);
+
+    me.remove_tiles(me.get_tiles());
+    me.add_tiles(get_tiles());
+    me.remove_tiles(candidate.move.tiles);
+    opponent.remove_tiles(opponent.get_tiles());
+    draw(opponent, hand_size);
+    draw(me, candidate.move.tiles.size());
 
-        if (result.valid) {
-            // check if all the resulting words are real words in the dictionary
-            for (size_t j = 0; j < result.words.size(); j++) {
-                if (!dictionary.is_word(result.words[j])) {
-                    valid = false;
+    // the opponent moves first; going out ends the game
+    for (size_t ply = 0; ply < simulation_plies && me.count_tiles() > 0 && opponent.count_tiles() > 0; ply++) {
+        ComputerPlayer& side = ply % 2 == 0 ? opponent : me;
+        Move move = side.get_move(position, dictionary);
+        if (move.kind != MoveKind::PLACE) {
+            continue;
+        }
+        double points = position.place(move).points + bonus(move);
+        outcome += ply % 2 == 0 ? -points : points;
+        side.remove_tiles(move.tiles);
+        draw(side, move.tiles.size());
+    }
+
+    return outcome + leave_value(me.get_tiles()) - leave_value(opponent.get_tiles());
+}
+
+double ComputerPlayer::leave_value(const std::vector<TileKind>& tiles) const {
+    if (leaves == nullptr) {
+        return 0;
+    }
+    size_t counts[LeaveTable::TILE_KINDS] = {};
+    for (const TileKind& tile : tiles) {
+        int index = LeaveTable::tile_index(tile.letter);
+        if (index >= 0) {
+            counts[index]++;
+        }
+    }
+    return leaves->value(counts);
+}
+
+std::vector<ComputerPlayer::RankedMove>
+ComputerPlayer::get_top_moves(const Board& board, const Dictionary& dictionary, size_t count) const {
+    auto start = std::chrono::steady_clock::now();
+    search_stats = SearchStats();
+    if (cached_dictionary != &dictionary || line_cache[0].size() != board.rows
+        || line_cache[1].size() != board.columns) {
+        cached_dictionary = &dictionary;
+        line_cache[0].assign(board.rows, LineCache());
+        line_cache[1].assign(board.columns, LineCache());
+    }
+    std::string rack = rack_key();
+    auto line_of = [](const Board::Anchor& anchor) {
+        return anchor.direction == Direction::DOWN ? anchor.position.column : anchor.position.row;
+    };
+
+    // only the anchors on lines without usable cached moves need searching
+    std::vector<Candidate> candidates;
+    std::vector<bool> cached[2] = {std::vector<bool>(board.rows), std::vector<bool>(board.columns)};
+    for (size_t d = 0; d < 2; d++) {
+        Direction direction = d == 0 ? Direction::ACROSS : Direction::DOWN;
+        for (size_t line = 0; line < line_cache[d].size(); line++) {
+            const LineCache& entry = line_cache[d][line];
+            if (entry.stamp == board.get_line_stamp(direction, line) && entry.rack == rack && entry.keep >= count) {
+                cached[d][line] = true;
+                candidates.insert(candidates.end(), entry.moves.begin(), entry.moves.end());
+            }
+        }
+    }
+    std::vector<Board::Anchor> all_anchors = board.get_anchors();
+    std::vector<Board::Anchor> anchors;
+    for (size_t i = 0; i < all_anchors.size(); i++) {
+        if (!cached[all_anchors[i].direction == Direction::DOWN ? 1 : 0][line_of(all_anchors[i])]) {
+            anchors.push_back(all_anchors[i]);
+        }
+    }
+
+    // the leave of a move is the rack minus the move's tiles
+    size_t rack_counts[LeaveTable::TILE_KINDS] = {};
+    for (auto it = this->collection.cbegin(); it != this->collection.cend(); ++it) {
+        int index = LeaveTable::tile_index(it->letter);
+        if (index >= 0) {
+            rack_counts[index]++;
+        }
+    }
+    auto equity = [&](const Move& move, size_t points) {
+        if (leaves == nullptr) {
+            return static_cast<double>(points);
+        }
+        size_t counts[LeaveTable::TILE_KINDS];
+        std::copy(rack_counts, rack_counts + LeaveTable::TILE_KINDS, counts);
+        for (size_t i = 0; i < move.tiles.size(); i++) {
+            int index = LeaveTable::tile_index(move.tiles[i].letter);
+            if (index >= 0 && counts[index] > 0) {
+                counts[index]--;
+            }
+        }
+        return points + leaves->value(counts);
+    };
+
+    // moves that did not come from a search have no counts of their own
+    auto lookup_start = std::chrono::steady_clock::now();
+    auto looked_up = [&](std::vector<RankedMove>& moves) {
+        nodes_visited = 0;
+        duplicates_avoided = 0;
+        anchors_skipped = 0;
+        search_complete = true;
+        auto now = std::chrono::steady_clock::now();
+        search_stats.lookup_time = now - lookup_start;
+        search_stats.total_time = now - start;
+        return std::move(moves);
+    };
+
+    // the first move of a game can come straight out of the opening book
+    if (book != nullptr && count <= book->get_keep()) {
+        std::vector<Move> opening = book->find(board, get_tiles());
+        std::vector<RankedMove> moves;
+        for (size_t i = 0; i < opening.size() && i < count; i++) {
+            PlaceResult result = score_move(opening[i], board, dictionary, &search_stats);
+            if (!result.valid) {
+                break;
+            }
+            double value = equity(opening[i], result.points);
+            moves.push_back(RankedMove{opening[i], result.points, std::move(result.words), value});
+        }
+        if (!opening.empty() && moves.size() == std::min(opening.size(), count)) {
+            return looked_up(moves);
+        }
+    }
+
+    // and so can any position searched before, by this player or by another one sharing the cache
+    uint64_t context = 0;
+    bool transposable = transpositions != nullptr && count <= TranspositionCache::MAX_MOVES
+                        && this->count_tiles() <= TranspositionCache::MAX_TILES;
+    if (transposable) {
+        context = cache_context(board, dictionary);
+        std::vector<TranspositionCache::Hit> hits;
+        if (transpositions->find(board.get_hash(), get_tiles(), context, count, hits)) {
+            std::vector<RankedMove> moves;
+            for (TranspositionCache::Hit& hit : hits) {
+                PlaceResult result = score_move(hit.move, board, dictionary, &search_stats);
+                if (!result.valid || result.points != hit.points) {
                     break;
                 }
+                moves.push_back(RankedMove{std::move(hit.move), hit.points, std::move(result.words), hit.equity});
+            }
+            if (moves.size() == hits.size()) {
+                return looked_up(moves);
             }
-            if (!valid) {
+        }
+    }
+    search_stats.lookup_time = std::chrono::steady_clock::now() - lookup_start;
+
+    // when only the best move is wanted, nothing that cannot beat the best move so far needs searching,
+    // and the cached lines already hold moves to beat
+    Bounds bounds;
+    bool bounded = pruning && count == 1;
+    if (bounded) {
+        bounds.leave = leaves == nullptr || this->count_tiles() == 0 ? 0 : get_best_exchange().equity;
+        for (size_t i = 0; i < candidates.size(); i++) {
+            bounds.best = std::max(bounds.best.load(), candidates[i].ranked.equity);
+        }
+    }
+
+    // score every move as soon as it is generated and only keep it if it is among the best of its anchor so far.
+    // Every anchor is searched by a single worker, so its heap needs no locking.
+    std::vector<std::vector<Candidate>> heaps(anchors.size());
+    search_anchors(
+            board,
+            dictionary,
+            anchors,
+            [&](SearchContext& search, const Move& move) {
+                PlaceResult result = score_move(move, board, dictionary, &search.stats);
+                if (!result.valid) {
+                    return;
+                }
+                if (search.budget != nullptr) {
+                    search.budget->found = true;
+                    size_t good_enough = search.budget->effort.good_enough;
+                    if (good_enough > 0 && result.points >= good_enough) {
+                        search.budget->exhausted = true;
+                    }
+                }
+                double value = equity(move, result.points);
+                offer(heaps[search.anchor],
+                      count,
+                      move,
+                      result,
+                      value,
+                      anchor_rank(anchors[search.anchor], board),
+                      search.order);
+                if (bounded) {
+                    double best = bounds.best.load();
+                    while (value > best && !bounds.best.compare_exchange_weak(best, value)) {
+                    }
+                }
+            },
+            true,
+            bounded ? &bounds : nullptr,
+            prunes_blanks());
+
+    // the best moves of a line are among the best moves of its anchors
+    for (size_t d = 0; d < 2; d++) {
+        for (size_t line = 0; line < line_cache[d].size(); line++) {
+            if (!cached[d][line]) {
+                line_cache[d][line] = LineCache();
+            }
+        }
+    }
+    std::vector<bool> pruned[2] = {std::vector<bool>(board.rows), std::vector<bool>(board.columns)};
+    for (size_t i = 0; i < anchors.size(); i++) {
+        size_t d = anchors[i].direction == Direction::DOWN ? 1 : 0;
+        LineCache& entry = line_cache[d][line_of(anchors[i])];
+        std::move(heaps[i].begin(), heaps[i].end(), std::back_inserter(entry.moves));
+        if (bounded && bounds.pruned[i]) {
+            pruned[d][line_of(anchors[i])] = true;
+        }
+    }
+    for (size_t d = 0; d < 2; d++) {
+        Direction direction = d == 0 ? Direction::ACROSS : Direction::DOWN;
+        for (size_t line = 0; line < line_cache[d].size(); line++) {
+            if (cached[d][line]) {
                 continue;
             }
-            if (result.points > highest) {
-                highest = result.points;
-                index = i;
+            LineCache& entry = line_cache[d][line];
+            size_t kept = std::min(count, entry.moves.size());
+            std::partial_sort(entry.moves.begin(), entry.moves.begin() + kept, entry.moves.end(), ranks_before);
+            entry.moves.resize(kept);
+            candidates.insert(candidates.end(), entry.moves.begin(), entry.moves.end());
+            // a search cut short by its budget may have missed moves, and so may a line that lost moves to pruning,
+            // since they only had to lose to the best move on another line
+            if (search_complete && !pruned[d][line]) {
+                entry.stamp = board.get_line_stamp(direction, line);
+                entry.rack = rack;
+                entry.keep = count;
+            }
+        }
+    }
+
+    size_t kept = std::min(count, candidates.size());
+    std::partial_sort(candidates.begin(), candidates.begin() + kept, candidates.end(), ranks_before);
+
+    std::vector<RankedMove> top;
+    for (size_t i = 0; i < kept; i++) {
+        top.push_back(std::move(candidates[i].ranked));
+    }
+    if (transposable && search_complete) {
+        std::vector<TranspositionCache::Hit> found;
+        for (const RankedMove& move : top) {
+            found.push_back(TranspositionCache::Hit{move.move, move.points, move.equity});
+        }
+        transpositions->store(board.get_hash(), get_tiles(), context, count, found);
+    }
+    search_stats.total_time = std::chrono::steady_clock::now() - start;
+    return top;
+}
+
+std::vector<Move> ComputerPlayer::get_legal_moves(const Board& board, const Dictionary& dictionary) const {
+    auto start = std::chrono::steady_clock::now();
+    search_stats = SearchStats();
+    std::vector<Board::Anchor> anchors = board.get_anchors();
+    std::vector<std::vector<Move>> per_anchor(anchors.size());
+    search_anchors(board, dictionary, anchors, [&](SearchContext& search, const Move& move) {
+        if (score_move(move, board, dictionary, &search.stats).valid) {
+            per_anchor[search.anchor].push_back(move);
+        }
+    });
+
+    std::vector<Move> legal_moves;
+    for (size_t i = 0; i < per_anchor.size(); i++) {
+        legal_moves.insert(legal_moves.end(), per_anchor[i].begin(), per_anchor[i].end());
+    }
+    search_stats.total_time = std::chrono::steady_clock::now() - start;
+    return legal_moves;
+}
+
+ComputerPlayer::MoveEnumerator ComputerPlayer::enumerate_moves(const Board& board, const Dictionary& dictionary) const {
+    std::unique_ptr<MoveEnumerator::State> state(new MoveEnumerator::State());
+    state->player = this;
+    state->board = &board;
+    state->dictionary = &dictionary;
+    state->gaddag = dictionary.get_gaddag();
+    if (state->gaddag == nullptr) {
+        state->gaddag = std::make_shared<Gaddag>(Gaddag::build(dictionary));
+    }
+    state->anchors = board.get_anchors();
+    compute_cross_checks(Direction::ACROSS, board, dictionary, state->cross_checks[0]);
+    compute_cross_checks(Direction::DOWN, board, dictionary, state->cross_checks[1]);
+    state->search = make_context();
+    state->search.cross_checks = state->cross_checks;
+    MoveEnumerator::State* shared = state.get();
+    state->search.visit = [shared](SearchContext&, const Move& move) {
+        shared->pending = move;
+        shared->recorded = true;
+    };
+    return MoveEnumerator(std::move(state));
+}
+
+// How far a MoveEnumerator::Frame has got; EXTEND frames use the first group, ADVANCE frames the second
+enum EnumeratorStep : uint8_t {
+    START,
+    NEXT_EDGE,
+    TRY_BLANK,
+    AFTER_BLANK,
+    TRY_TILE,
+    AFTER_TILE,
+    RIGHT_ON,
+    TURNED,
+    GROW,
+    DONE,
+};
+
+bool ComputerPlayer::MoveEnumerator::next(Move& move) {
+    State& s = *state;
+    while (resume()) {
+        if (s.player->score_move(s.pending, *s.board, *s.dictionary, &s.search.stats).valid) {
+            move = std::move(s.pending);
+            return true;
+        }
+    }
+    return false;
+}
+
+size_t ComputerPlayer::MoveEnumerator::get_nodes_visited() const { return state->search.nodes; }
+
+bool ComputerPlayer::MoveEnumerator::resume() {
+    State& s = *state;
+    const ComputerPlayer& player = *s.player;
+    const Board& board = *s.board;
+    const Gaddag& gaddag = *s.gaddag;
+    SearchContext& search = s.search;
+    s.recorded = false;
+
+    // the same steps as gaddag_extend and gaddag_advance, with a push where they recurse and a pop where they return
+    auto push = [&s](Frame::Kind kind, Board::Position square, Gaddag::Node node, bool leftward) {
+        s.stack.push_back(Frame{kind, START, leftward, 0, square, node, nullptr});
+    };
+    while (!s.recorded) {
+        if (s.stack.empty()) {
+            if (s.anchor == s.anchors.size()) {
+                return false;
+            }
+            search.anchor = s.anchor;
+            search.order = 0;
+            search.stats.anchors++;
+            push(Frame::EXTEND, s.anchors[s.anchor].position, gaddag.root(), true);
+            s.anchor++;
+            continue;
+        }
+
+        // a push may move the stack, so the frame is only used before it
+        Frame& frame = s.stack.back();
+        const Board::Anchor& anchor = s.anchors[search.anchor];
+        std::vector<TileKind>& placed = frame.leftward ? search.left : search.right;
+        if (frame.kind == Frame::EXTEND) {
+            switch (frame.step) {
+            case START: {
+                search.nodes++;
+                if (board.in_bounds_and_has_tile(frame.square)) {
+                    Gaddag::Node next = gaddag.child(frame.node, board.letter_at(frame.square));
+                    frame.step = DONE;
+                    if (next != Gaddag::NONE) {
+                        push(Frame::ADVANCE, frame.square, next, frame.leftward);
+                    }
+                    break;
+                }
+                frame.edge = gaddag.edges_begin(frame.node);
+                frame.step = NEXT_EDGE;
+                break;
+            }
+            case NEXT_EDGE: {
+                const std::vector<uint32_t>& masks = search.cross_checks[anchor.direction == Direction::DOWN ? 1 : 0];
+                uint32_t allowed = masks[frame.square.row * board.columns + frame.square.column];
+                for (; frame.edge != gaddag.edges_end(frame.node); frame.edge++) {
+                    int index = rack_index(frame.edge->letter);
+                    if (index >= 0 && index != 26 && (allowed & (1u << index))) {
+                        frame.index = index;
+                        break;
+                    }
+                }
+                if (frame.edge == gaddag.edges_end(frame.node)) {
+                    frame.step = DONE;
+                    break;
+                }
+                search.stats.rack_lookups += 2;
+                frame.step = TRY_BLANK;
+                break;
+            }
+            case TRY_BLANK:
+                frame.step = TRY_TILE;
+                if (search.counts[26] > 0) {
+                    TileKind add(search.kinds[26]);
+                    add.assigned = frame.edge->letter;
+                    search.counts[26]--;
+                    placed.push_back(add);
+                    frame.step = AFTER_BLANK;
+                    push(Frame::ADVANCE, frame.square, frame.edge->target, frame.leftward);
+                }
+                break;
+            case AFTER_BLANK:
+                placed.pop_back();
+                search.counts[26]++;
+                frame.step = TRY_TILE;
+                break;
+            case TRY_TILE:
+                if (search.counts[frame.index] > 0) {
+                    search.counts[frame.index]--;
+                    placed.push_back(search.kinds[frame.index]);
+                    frame.step = AFTER_TILE;
+                    push(Frame::ADVANCE, frame.square, frame.edge->target, frame.leftward);
+                } else {
+                    frame.edge++;
+                    frame.step = NEXT_EDGE;
+                }
+                break;
+            case AFTER_TILE:
+                placed.pop_back();
+                search.counts[frame.index]++;
+                frame.edge++;
+                frame.step = NEXT_EDGE;
+                break;
+            default:
+                s.stack.pop_back();
+                break;
+            }
+            continue;
+        }
+
+        // records the word if it ends just before `after`, see gaddag_advance
+        auto record_word = [&](Gaddag::Node end, Board::Position after) {
+            if (gaddag.is_final(end) && !board.in_bounds_and_has_tile(after)) {
+                player.record_placement(anchor, search, board);
+            }
+        };
+        Board::Position before = frame.square.translate(anchor.direction, -1);
+        Board::Position after
+                = frame.leftward ? anchor.position.translate(anchor.direction) : frame.square.translate(anchor.direction);
+        switch (frame.step) {
+        case START:
+            if (!frame.leftward) {
+                frame.step = RIGHT_ON;
+                record_word(frame.node, after);
+            } else if (board.in_bounds_and_has_tile(before)) {
+                // the word cannot start right after a tile, so keep going left through it
+                frame.step = DONE;
+                push(Frame::EXTEND, before, frame.node, true);
+            } else {
+                // the left part is done: cross the separator and continue to the right of the anchor
+                frame.step = TURNED;
+                Gaddag::Node turn = gaddag.child(frame.node, Gaddag::SEPARATOR);
+                if (turn != Gaddag::NONE) {
+                    record_word(turn, after);
+                }
+            }
+            break;
+        case RIGHT_ON:
+            frame.step = DONE;
+            if (board.is_in_bounds(after)) {
+                push(Frame::EXTEND, after, frame.node, false);
             }
+            break;
+        case TURNED: {
+            frame.step = GROW;
+            Gaddag::Node turn = gaddag.child(frame.node, Gaddag::SEPARATOR);
+            if (turn != Gaddag::NONE && board.is_in_bounds(after)) {
+                push(Frame::EXTEND, after, turn, false);
+            }
+            break;
+        }
+        case GROW:
+            // or grow the left part by another rack tile, as far as the anchor's limit allows
+            frame.step = DONE;
+            if (board.is_in_bounds(before) && search.left.size() <= anchor.limit) {
+                push(Frame::EXTEND, before, frame.node, true);
+            }
+            break;
+        default:
+            s.stack.pop_back();
+            break;
+        }
+    }
+    return true;
+}
+
+PlaceResult ComputerPlayer::score_move(
+        const Move& move, const Board& board, const Dictionary& dictionary, SearchStats* stats) const {
+    if (move.tiles.size() == 0) {
+        return PlaceResult("Empty move");
+    }
+    bool timed = stats != nullptr && time_scoring;
+    std::chrono::steady_clock::time_point start;
+    if (timed) {
+        start = std::chrono::steady_clock::now();
+    }
+    if (stats != nullptr) {
+        stats->placements_tested++;
+    }
+    PlaceResult result = board.test_place(move);
+    // check if all the resulting words are real words in the dictionary
+    for (size_t j = 0; result.valid && j < result.words.size(); j++) {
+        if (stats != nullptr) {
+            stats->word_checks++;
+        }
+        if (!dictionary.is_word(result.words[j])) {
+            if (stats != nullptr) {
+                stats->words_rejected++;
+            }
+            result = PlaceResult(result.words[j] + " is not a word");
+        }
+    }
+    if (timed) {
+        stats->scoring_time += std::chrono::steady_clock::now() - start;
+    }
+    return result;
+}
+
+void ComputerPlayer::set_threads(size_t threads) {
+    if (threads <= 1) {
+        pool = nullptr;
+    } else {
+        pool = std::make_shared<WorkStealingPool>(threads);
+    }
+    chooser = nullptr;
+}
+
+size_t ComputerPlayer::get_threads() const { return pool == nullptr ? 1 : pool->size(); }
+
+void ComputerPlayer::set_engine(Engine engine) {
+    this->engine = engine;
+    cached_dictionary = nullptr;
+    chooser = nullptr;
+}
+
+ComputerPlayer::Engine ComputerPlayer::get_engine() const { return engine; }
+
+void ComputerPlayer::set_leave_table(std::shared_ptr<const LeaveTable> leaves) {
+    this->leaves = leaves;
+    cached_dictionary = nullptr;
+}
+
+void ComputerPlayer::set_opening_book(std::shared_ptr<const OpeningBook> book) {
+    this->book = book;
+    chooser = nullptr;
+}
+
+void ComputerPlayer::set_transposition_cache(std::shared_ptr<TranspositionCache> cache) {
+    transpositions = cache;
+    chooser = nullptr;
+}
+
+uint64_t ComputerPlayer::cache_context(const Board& board, const Dictionary& dictionary) const {
+    uint64_t context = OpeningBook::fingerprint(board);
+    context = zobrist_key(context ^ dictionary.get_fingerprint());
+    context = zobrist_key(context ^ (leaves == nullptr ? 0 : leaves->get_fingerprint()));
+    bool use_gaddag = engine == Engine::GADDAG && dictionary.get_gaddag() != nullptr;
+    return zobrist_key(context ^ (use_gaddag ? 2 : 1) ^ (prunes_blanks() ? 4 : 0));
+}
+
+uint64_t ComputerPlayer::ponder_context(const Board& board, const Dictionary& dictionary) const {
+    uint64_t settings[] = {
+            effort.anchor_nodes,
+            effort.good_enough,
+            effort.greedy,
+            static_cast<uint64_t>(time_budget.count()),
+            node_budget,
+            book != nullptr,
+            simulation_candidates,
+            simulation_plies,
+            simulation_iterations,
+            simulation_seed,
+            lookahead_candidates,
+            lookahead_samples,
+            static_cast<uint64_t>(lookahead_time.count()),
+            lookahead_seed,
+            static_cast<uint64_t>(endgame_time.count())};
+    uint64_t context = cache_context(board, dictionary);
+    for (uint64_t setting : settings) {
+        context = zobrist_key(context ^ setting);
+    }
+    return context;
+}
+
+void ComputerPlayer::set_effort(const Effort& effort) { this->effort = effort; }
+
+const ComputerPlayer::Effort& ComputerPlayer::get_effort() const { return effort; }
+
+void ComputerPlayer::set_playout_effort(const Effort& effort) {
+    playout_effort = effort;
+    chooser = nullptr;
+}
+
+void ComputerPlayer::set_budget(std::chrono::milliseconds time, size_t nodes) {
+    time_budget = time;
+    node_budget = nodes;
+    chooser = nullptr;
+}
+
+bool ComputerPlayer::get_search_complete() const { return search_complete; }
+
+void ComputerPlayer::set_pruning(bool pruning) {
+    this->pruning = pruning;
+    chooser = nullptr;
+}
+
+void ComputerPlayer::set_blank_pruning(bool blank_pruning) {
+    this->blank_pruning = blank_pruning;
+    cached_dictionary = nullptr;
+    chooser = nullptr;
+}
+
+bool ComputerPlayer::prunes_blanks() const { return blank_pruning && leaves == nullptr; }
+
+void ComputerPlayer::set_unseen_tiles(const std::vector<TileKind>& tiles, size_t in_bag) {
+    stop_pondering();
+    unseen_tiles = tiles;
+    unseen_in_bag = in_bag;
+}
+
+const std::vector<TileKind>& ComputerPlayer::get_unseen_tiles() const { return unseen_tiles; }
+
+size_t ComputerPlayer::get_unseen_in_bag() const { return unseen_in_bag; }
+
+void ComputerPlayer::set_strategy(std::shared_ptr<const Strategy> strategy) {
+    stop_pondering();
+    this->strategy = strategy;
+    chooser = nullptr;
+}
+
+std::shared_ptr<const Strategy> ComputerPlayer::get_strategy() const { return strategy; }
+
+ComputerPlayer& ComputerPlayer::get_chooser(const std::function<void(ComputerPlayer&)>& configure) const {
+    if (chooser == nullptr) {
+        chooser = std::make_shared<ComputerPlayer>(*this);
+        chooser->strategy = nullptr;
+        chooser->pondering = nullptr;
+        // the moves are logged as this player's (see choose_move)
+        chooser->search_log = nullptr;
+        configure(*chooser);
+    }
+    chooser->remove_tiles(chooser->get_tiles());
+    chooser->add_tiles(get_tiles());
+    chooser->set_unseen_tiles(unseen_tiles, unseen_in_bag);
+    return *chooser;
+}
+
+void ComputerPlayer::set_endgame_time(std::chrono::milliseconds time) {
+    endgame_time = time;
+    chooser = nullptr;
+}
+
+void ComputerPlayer::set_simulation(size_t candidates, size_t plies, size_t iterations, uint32_t seed) {
+    simulation_candidates = candidates;
+    simulation_plies = plies;
+    simulation_iterations = iterations;
+    simulation_seed = seed;
+}
+
+void ComputerPlayer::set_lookahead(size_t candidates, size_t samples, std::chrono::milliseconds time, uint32_t seed) {
+    lookahead_candidates = candidates;
+    lookahead_samples = samples;
+    lookahead_time = time;
+    lookahead_seed = seed;
+}
+
+double ComputerPlayer::get_lookahead_coverage() const { return lookahead_coverage; }
+
+ComputerPlayer::~ComputerPlayer() {
+    if (pondering.use_count() == 1) {
+        stop_pondering();
+    }
+}
+
+void ComputerPlayer::start_pondering(const Board& board, const Dictionary& dictionary) {
+    stop_pondering();
+    pondering = std::make_shared<Ponder>();
+    pondering->thinker.reset(new ComputerPlayer(*this));
+    ComputerPlayer& thinker = *pondering->thinker;
+    thinker.pondering = nullptr;
+    thinker.pool = nullptr;
+    thinker.search_log = nullptr;
+    thinker.interrupt = &pondering->stop;
+    pondering->context = ponder_context(board, dictionary);
+    pondering->thread = std::thread(
+            &ComputerPlayer::ponder,
+            &thinker,
+            std::ref(*pondering),
+            board,
+            std::cref(dictionary),
+            unseen_tiles,
+            unseen_in_bag);
+}
+
+void ComputerPlayer::stop_pondering() const {
+    if (pondering != nullptr && pondering->thread.joinable()) {
+        pondering->stop = true;
+        pondering->thread.join();
+    }
+}
+
+void ComputerPlayer::finish_pondering() const {
+    if (pondering != nullptr && pondering->thread.joinable()) {
+        pondering->thread.join();
+    }
+}
+
+bool ComputerPlayer::get_ponder_hit() const { return ponder_hit; }
+
+void ComputerPlayer::ponder(
+        Ponder& state, Board board, const Dictionary& dictionary, std::vector<TileKind> unseen, size_t in_bag) const {
+    // every line of the board as it is goes into the line cache; with a count over 1 pruning leaves none out
+    get_top_moves(board, dictionary, 2);
+    if (state.stop) {
+        return;
+    }
+    state.warmed = search_complete;
+    if (!picks_by_equity(in_bag)) {
+        return;
+    }
+    // passing and exchanging leave the board and the number of tiles in the bag as they are
+    std::string rack = rack_key();
+    // a search the stop cut short found no answer, only the best move of what it got through
+    auto answer = [&](const Board& position, size_t left, const Move& move) {
+        if (!state.stop && CompactMove::fits(move)) {
+            state.answers[position.get_hash()] = Ponder::Answer{rack, left, CompactMove(move)};
+        }
+    };
+    answer(board, in_bag, choose_move(board, dictionary, in_bag));
+
+    // the replies the opponent's racks lead to, most often played first; boards tell replies apart
+    ComputerPlayer opponent("opponent", get_hand_size());
+    opponent.engine = engine;
+    opponent.leaves = leaves;
+    opponent.interrupt = interrupt;
+    std::vector<std::pair<size_t, Move>> replies;
+    std::unordered_map<uint64_t, size_t> reply_index;
+    size_t rack_size = std::min(get_hand_size(), unseen.size());
+    for (size_t i = 0; i < PONDER_RACKS && rack_size > 0 && !state.stop; i++) {
+        std::seed_seq seed{simulation_seed, static_cast<uint32_t>(i)};
+        std::mt19937 random(seed);
+        std::shuffle(unseen.begin(), unseen.end(), random);
+        opponent.remove_tiles(opponent.get_tiles());
+        opponent.add_tiles(std::vector<TileKind>(unseen.begin(), unseen.begin() + rack_size));
+        std::vector<RankedMove> top = opponent.get_top_moves(board, dictionary, 1);
+        if (top.empty()) {
+            continue;
+        }
+        board.place(top[0].move);
+        auto found = reply_index.emplace(board.get_hash(), replies.size());
+        board.undo_place();
+        if (found.second) {
+            replies.push_back(std::make_pair(0, top[0].move));
         }
+        replies[found.first->second].first++;
     }
-    if (index == -1) {
-        return best_move;
+    std::stable_sort(replies.begin(), replies.end(), [](const auto& a, const auto& b) { return a.first > b.first; });
+
+    // answered on a copy, so that the predicted boards do not push the lines of the real one out of the line cache
+    ComputerPlayer responder(*this);
+    responder.pondering = nullptr;
+    for (size_t i = 0; i < replies.size() && i < PONDER_REPLIES && !state.stop; i++) {
+        const Move& reply = replies[i].second;
+        size_t left = in_bag - std::min(reply.tiles.size(), in_bag);
+        if (!picks_by_equity(left)) {
+            continue;
+        }
+        board.place(reply);
+        answer(board, left, responder.choose_move(board, dictionary, left));
+        board.undo_place();
     }
+}
+
+double ComputerPlayer::get_playouts_per_second() const { return playouts_per_second; }
+
+double ComputerPlayer::get_pre_endgame_coverage() const { return pre_endgame_coverage; }
+
+size_t ComputerPlayer::get_nodes_visited() const { return nodes_visited; }
+
+size_t ComputerPlayer::get_duplicates_avoided() const { return duplicates_avoided; }
+
+size_t ComputerPlayer::get_anchors_skipped() const { return anchors_skipped; }
 
-    best_move = legal_moves[index];
+const ComputerPlayer::SearchStats& ComputerPlayer::get_search_stats() const { return search_stats; }
 
-    return best_move;
+void ComputerPlayer::set_instrumentation(bool time_scoring, std::ostream* log) {
+    this->time_scoring = time_scoring;
+    search_log = log;
+    chooser = nullptr;
 }
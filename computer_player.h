@@ -1,16 +1,78 @@
 #ifndef COMPUTER_PLAYER_H
 #define COMPUTER_PLAYER_H
 
+#include "gaddag.h"
+#include "leave_table.h"
 #include "move.h"
+#include "opening_book.h"
+#include "place_result.h"
 #include "player.h"
+#include "transposition_cache.h"
+#include "work_stealing_pool.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+class Strategy;
 
 class ComputerPlayer : public Player {
   public:
+    /*
+    The move generators get_move can run. Both produce the same set of legal moves.
+
+    TRIE: grows a left part up to the anchor's limit, then extends it to the right through the dictionary trie
+    GADDAG: grows words outward from the anchor through the dictionary's GADDAG, skipping letters that would form
+        an invalid perpendicular word. Needs Dictionary::build_gaddag() and falls back to TRIE without it.
+
+    Both build their moves in place, pushing and popping the tiles of one Move (the trie engine) or of the left and
+    right stacks of the search (the GADDAG engine), so a move of any length costs no allocation once the vectors have
+    grown to it.
+    */
+    enum class Engine {
+        TRIE,
+        GADDAG,
+    };
+
+    /*
+    A valid move together with the points it scores and every word it forms.
+    equity is what the moves are ranked by: the points plus the value of the tiles the move leaves on the rack when
+    there is a leave table, otherwise just the points.
+    */
+    struct RankedMove {
+        Move move;
+        size_t points;
+        std::vector<std::string> words;
+        double equity;
+    };
+
+    /*
+    A candidate move and the average outcome of playing it out (see simulate)
+    */
+    struct SimulatedMove {
+        RankedMove ranked;
+        double average;
+    };
+
+    // Added to a move that uses the whole hand
+    static const size_t BINGO_BONUS = 50;
+
     /* HW5: DECLARE AND IMPLEMENT THIS
     Should have one parameterized constructor that takes a string name (const reference) and a size_t hand size.
     */
     ComputerPlayer(const std::string& name, size_t hand_size) : Player(name, hand_size){};  // <--- FIX THIS LINE
 
+    // Copies share their pondering, and the last one destroyed stops it
+    ~ComputerPlayer();
+
     /* HW5: IMPLEMENT THIS
     Returns the move found by running the algorithm given here:
         https://www.cs.cmu.edu/afs/cs/academic/class/15451-s06/www/lectures/scrabble.pdf
@@ -21,7 +83,457 @@ class ComputerPlayer : public Player {
 
     bool is_human() const { return false; }
 
+    /*
+    Sets how many threads get_move spreads the anchors over.
+
+    With more than one thread the anchors are searched on a work-stealing pool. Each worker keeps its own copy of the
+    rack and its own best move, and the per-worker results are merged in anchor order, so the move returned is the same
+    for every thread count.
+    */
+    void set_threads(size_t threads);
+
+    size_t get_threads() const;
+
+    /*
+    Also clears the move cache, since the engines find tied moves in a different order
+    */
+    void set_engine(Engine engine);
+
+    Engine get_engine() const;
+
+    /*
+    Returns every valid move for the current hand, in the order the engine generated them.
+    Every placement shows up once, see record.
+    */
+    std::vector<Move> get_legal_moves(const Board& board, const Dictionary& dictionary) const;
+
+    class MoveEnumerator;
+
+    /*
+    Returns an enumerator that hands out the moves get_legal_moves returns, in the same order, one per call of
+    MoveEnumerator::next, so a caller can stop early or work on every move as it comes without holding them all.
+    The search is the GADDAG engine's, run on this thread, whichever engine is set; a dictionary without a GADDAG
+    gets one built for the enumerator alone. The rack is copied, but the player, board and dictionary have to
+    outlive the enumerator and stay as they are.
+    */
+    MoveEnumerator enumerate_moves(const Board& board, const Dictionary& dictionary) const;
+
+    /*
+    Ranks moves by equity instead of points from now on: the points plus the leave's value in leaves.
+    nullptr goes back to ranking by points. Also clears the move cache.
+    */
+    void set_leave_table(std::shared_ptr<const LeaveTable> leaves);
+
+    /*
+    Returns the count valid moves with the highest equity, best first.
+
+    Only a bounded heap of count moves per anchor is kept while the moves are generated, so the cost does not grow
+    with the number of legal moves. Ties go to the move found from the earlier anchor, and then to the move generated
+    first for that anchor, so the list is the same for every thread count.
+
+    The best moves of every line are cached along with the line's stamp (see Board::get_line_stamp) and the rack, so
+    a later call with the same rack only searches the lines that the moves placed since have changed.
+    */
+    std::vector<RankedMove> get_top_moves(const Board& board, const Dictionary& dictionary, size_t count) const;
+
+    /*
+    Makes get_top_moves, and so get_move, look the first move of a game up in book instead of searching for it, when
+    the book holds the rack and at least as many moves as are asked for. The book has to have been filled with the
+    same dictionary, tile values and leave table, and a move the dictionary does not allow sends get_top_moves back
+    to searching. nullptr turns this off.
+    */
+    void set_opening_book(std::shared_ptr<const OpeningBook> book);
+
+    /*
+    Makes get_top_moves, and so get_move, look every position up in cache before searching it, and store what a
+    complete search finds there. One cache can be shared by any number of players on any number of threads: positions
+    are told apart by the board's hash and the rack, and by the dictionary, leave table, engine and blank pruning of
+    the player that searched them, so a player only finds the moves its own search would have found. A stored move
+    the board no longer allows, which only a hash collision can cause, sends get_top_moves back to searching.
+    nullptr turns this off.
+    */
+    void set_transposition_cache(std::shared_ptr<TranspositionCache> cache);
+
+    /*
+    Returns the exchange that keeps the leave the leave table values most, as a RankedMove with no points whose equity
+    is the value of the kept leave. Every distinct sub-multiset of the rack is tried as the leave, so duplicate tiles
+    are only tried once (at most 127 leaves for 7 tiles), and the whole rack is never kept.
+    Without a leave table or tiles to exchange this is a pass with an equity of minus infinity.
+
+    get_move exchanges when this beats the equity of its best placement, or of passing if it has none, and the bag
+    holds a full rack of tiles (see set_unseen_tiles).
+    */
+    RankedMove get_best_exchange() const;
+
+    /*
+    Limits how long get_move and get_top_moves may search: time is wall clock time and nodes is the number of search
+    nodes over all threads. Zero means no limit. get_legal_moves always searches everything.
+
+    With a budget the anchors are searched most promising first, so a search that runs out early still returns the
+    best move it has seen. The budget is checked every BUDGET_CHECK_INTERVAL nodes per thread.
+    */
+    void set_budget(std::chrono::milliseconds time, size_t nodes);
+
+    /*
+    Lets a search for the single best move (get_top_moves with a count of 1, which is what get_move uses) skip every
+    anchor and partial placement whose score cannot beat the best move found so far. Anchors are searched highest
+    bound first, so that strong moves are found early. The moves returned are exactly the same either way; only
+    get_nodes_visited goes down. On by default.
+    */
+    void set_pruning(bool pruning);
+
+    /*
+    Leaves out every placement that plays a blank as a letter while a real tile of that letter stays on the rack. The
+    same squares with the real tile in place of the blank score at least as much and keep the blank, which is worth
+    more than any one letter, so with two blanks and a rack full of candidates for them this drops most of the moves
+    before they are scored. Only the searches for the best moves (get_top_moves and get_move) prune, and only without
+    a leave table, whose values of the leaves with and without the blank decide which of the two is worth more;
+    get_legal_moves and enumerate_moves always return every move. On by default; the endgame solver turns it off,
+    since there a held blank can still make up for the points given away by a later real tile on a bigger multiplier.
+    */
+    void set_blank_pruning(bool blank_pruning);
+
+    /*
+    How much work get_move and get_top_moves put into a move, for players that have to be cheap rather than exact,
+    such as the opponents in bulk simulations. The default is a full search; any of these makes it a capped one:
+
+    anchor_nodes: search nodes an anchor may take before the search moves on to the next one; 0 for no limit
+    good_enough: points that end the search at the first move scoring at least that many; 0 never ends it early
+    greedy: end the search with the first anchor that has a valid move, and play the best move of that anchor
+
+    A capped search runs on a single thread, the most promising anchors first (see set_pruning and set_budget), so
+    the move it finds is the same every time. It never simulates, looks ahead or solves the endgame, and it only
+    stores what it finds in the line and transposition caches if none of the caps cut it short.
+    */
+    struct Effort {
+        size_t anchor_nodes = 0;
+        size_t good_enough = 0;
+        bool greedy = false;
+
+        bool capped() const { return anchor_nodes > 0 || good_enough > 0 || greedy; }
+    };
+
+    void set_effort(const Effort& effort);
+
+    const Effort& get_effort() const;
+
+    /*
+    Sets the effort of both players in the playouts of simulate; a full search by default
+    */
+    void set_playout_effort(const Effort& effort);
+
+    /*
+    Returns whether the last search covered every anchor, rather than stopping because its budget or its effort
+    (see set_effort) ran out
+    */
+    bool get_search_complete() const;
+
+    static const size_t BUDGET_CHECK_INTERVAL = 256;
+
+    /*
+    Tells the player which tiles it cannot see: the bag plus the other players' racks, in_bag of them still in the bag.
+    Simulations draw the opponent's rack and everybody's new tiles from these. Once the bag is empty they are exactly
+    the opponent's rack, which is what the endgame solver needs.
+    */
+    void set_unseen_tiles(const std::vector<TileKind>& tiles, size_t in_bag);
+
+    const std::vector<TileKind>& get_unseen_tiles() const;
+
+    size_t get_unseen_in_bag() const;
+
+    /*
+    Hands every move get_move makes to strategy (see Strategy) instead of picking it from this player's own settings,
+    until it is set back to nullptr. The strategy decides how moves are picked, so get_move never answers from
+    pondering while one is set; a SearchStrategy still searches with this player's budget, book, caches and threads
+    (see get_chooser).
+    */
+    void set_strategy(std::shared_ptr<const Strategy> strategy);
+
+    std::shared_ptr<const Strategy> get_strategy() const;
+
+    /*
+    Returns the player a strategy picks this player's moves with (see SearchStrategy): a copy of this player, made the
+    first time it is asked for and kept from move to move, so that its caches carry over. It shares this player's
+    thread pool, opening book and transposition cache, and keeps its engine, budget, pruning, endgame time and timing
+    settings, but never pondering or a strategy of its own. configure sets it up once, when it is made; every call
+    hands it this player's rack and unseen tiles as they are now. Every setter of those settings, set_strategy
+    included, makes the next call start over with a new copy.
+    */
+    ComputerPlayer& get_chooser(const std::function<void(ComputerPlayer&)>& configure) const;
+
+    /*
+    Makes get_move solve the endgame with an EndgameSolver once the bag is empty, and the pre-endgame (see
+    solve_pre_endgame) once it holds PRE_ENDGAME_BAG tiles or fewer, thinking for at most time.
+    Only meaningful with a single opponent. Zero turns both solvers off.
+    */
+    void set_endgame_time(std::chrono::milliseconds time);
+
+    // The most tiles the bag may hold for get_move to solve the pre-endgame
+    static const size_t PRE_ENDGAME_BAG = 6;
+
+    // How many moves by equity the pre-endgame solver weighs
+    static const size_t PRE_ENDGAME_CANDIDATES = 8;
+
+    /*
+    Weighs the best PRE_ENDGAME_CANDIDATES moves by equity against every way the unseen tiles can fall, and returns
+    them with their expected spread over the rest of the game, in the order get_top_moves ranked them.
+
+    For each candidate, every distinct draw of our replacement tiles and every distinct rest of the bag is a world,
+    weighted by its probability, in which the opponent holds the remaining unseen tiles. The endgame of each world
+    is then solved with an EndgameSolver, the rest of the bag drawn in a fixed order. Worlds are solved most likely
+    first, taking turns between the candidates, on the thread pool, with every solver sharing one transposition
+    table. Nothing new starts once the endgame time runs out, and each candidate is averaged over the worlds that
+    were solved for it.
+    */
+    std::vector<SimulatedMove> solve_pre_endgame(const Board& board, const Dictionary& dictionary) const;
+
+    /*
+    Returns the smallest share of the probability of its draws that the last pre-endgame solved for any candidate;
+    1 means every world was solved
+    */
+    double get_pre_endgame_coverage() const;
+
+    /*
+    Makes get_move pick its move by simulation: the best `candidates` moves by equity are each played out `iterations`
+    times, `plies` turns deep (2 to 4 is plenty), and the one with the best average outcome wins.
+    0 candidates turns simulation off. seed picks the random draws, so the same seed gives the same games.
+    */
+    void set_simulation(size_t candidates, size_t plies, size_t iterations, uint32_t seed = 0);
+
+    /*
+    Plays out the top candidates the way set_simulation describes and returns them with their average outcomes, in the
+    order get_top_moves ranked them.
+
+    One iteration draws an opponent rack and the order of the bag from the unseen tiles, then plays every candidate
+    with that same draw: the candidate, then the opponent's greedy reply, then ours, and so on for `plies` turns.
+    The outcome is our points minus theirs, plus our leave minus theirs at the end if there is a leave table.
+    Iterations run on the thread pool, each worker with its own board copy and players, and each iteration with its
+    own random stream seeded from the seed and its index, so the averages do not depend on the thread count.
+    A time budget (see set_budget) stops the simulation between iterations.
+    */
+    std::vector<SimulatedMove> simulate(const Board& board, const Dictionary& dictionary) const;
+
+    /*
+    Returns how many playouts, one candidate played out once, the last simulation finished per second
+    */
+    double get_playouts_per_second() const;
+
+    /*
+    Makes get_move look one reply ahead: the best `candidates` moves by equity are each weighed against the best
+    reply of `samples` opponent racks drawn from the unseen tiles, and the move whose equity minus the average points
+    of the reply is highest wins. time caps how long a move may take; zero lets every sample finish.
+    0 candidates turns lookahead off. Simulation (see set_simulation) takes precedence over it.
+    seed picks the racks, so the same seed gives the same racks.
+    */
+    void set_lookahead(size_t candidates, size_t samples, std::chrono::milliseconds time, uint32_t seed = 0);
+
+    /*
+    Weighs the top candidates the way set_lookahead describes and returns them with their equity minus the average
+    reply, in the order get_top_moves ranked them.
+
+    Sample i draws the same opponent rack for every candidate, seeded from the seed and i, so candidates are compared
+    on the same racks. Each reply is the opponent's highest scoring placement, bingo bonus included, found by a
+    pruned search for the single best move with no leave table; an opponent with no placement scores 0. The candidate
+    and sample pairs are independent and run on the thread pool, each worker placing candidates on its own copy of
+    the board and taking them back, sample by sample so that the time cap cuts every candidate short about evenly.
+    Each candidate is averaged over the samples that finished for it; one with none is ranked last.
+    Without unseen tiles (see set_unseen_tiles) the candidates keep their equity.
+    */
+    std::vector<SimulatedMove> look_ahead(const Board& board, const Dictionary& dictionary) const;
+
+    /*
+    Returns the smallest share of its samples that the last lookahead finished for any candidate; 1 means every
+    sample finished
+    */
+    double get_lookahead_coverage() const;
+
+    /*
+    Starts thinking about our next move in the background while the opponent thinks about theirs, on a copy of board.
+
+    Pondering runs on a copy of this player taken now, searching on a single thread, so it never touches this player's
+    caches or thread pool while get_move may be using them. Lines of the board that the opponent's move leaves alone
+    keep their moves in the line cache (see get_top_moves), so every line is searched first, and get_move takes those
+    lines over from the copy. Then the opponent is given PONDER_RACKS racks drawn from the unseen tiles (see
+    set_unseen_tiles), and our answer is worked out for each of the PONDER_REPLIES replies they play most often, and
+    for the board as it is in case the opponent passes or exchanges.
+    get_move stops pondering first, and answers at once if the board it is given is one of those and neither the rack,
+    the bag, the dictionary nor any setting that picks the move (see ponder_context) has changed since; all other
+    work done for predicted boards is dropped. The answer is the one get_move would have found.
+    Only moves picked by equity are pondered; simulation, the pre-endgame and the endgame always start from scratch.
+    */
+    void start_pondering(const Board& board, const Dictionary& dictionary);
+
+    /*
+    Stops pondering and waits for it; every search checks for the stop at every node, so this returns as soon as the
+    node being searched is done. set_unseen_tiles and get_move call it themselves.
+    */
+    void stop_pondering() const;
+
+    /*
+    Waits for pondering to finish everything it set out to do
+    */
+    void finish_pondering() const;
+
+    /*
+    Returns whether the last get_move took its move from pondering
+    */
+    bool get_ponder_hit() const;
+
+    // How many racks pondering draws for the opponent, and for how many of the replies they lead to it finds answers
+    static const size_t PONDER_RACKS = 16;
+    static const size_t PONDER_REPLIES = 4;
+
+    /*
+    Returns the number of search nodes the last call to get_move or get_legal_moves visited.
+    A node is one call of the recursive generator, which is one square tried for one partial word.
+    */
+    size_t get_nodes_visited() const;
+
+    /*
+    Returns how many moves the last search did not score because they were the same placement as another move
+    */
+    size_t get_duplicates_avoided() const;
+
+    /*
+    Returns how many anchors the last search skipped without generating a move from them, because their anchor_bound
+    could not beat the best move already found
+    */
+    size_t get_anchors_skipped() const;
+
+    /*
+    What the search behind the last get_move, get_top_moves or get_legal_moves did, to tell why one turn takes much
+    longer than another. A get_move that simulates or looks ahead only counts its own search for candidates.
+
+    anchors: anchors searched; anchors_skipped, see get_anchors_skipped
+    nodes, duplicates: see get_nodes_visited and get_duplicates_avoided
+    rack_lookups: times the generators looked for a tile on the rack
+    candidates: moves the generators handed on to be scored
+    placements_tested, word_checks, words_rejected: calls of Board::test_place and Dictionary::is_word, and the
+        words is_word did not find
+    lookup_time: looking the moves up in the opening book, the transposition cache or the pondered answers
+    prepare_time: cross checks, bounds and the order of the anchors
+    search_time: generating and scoring moves
+    scoring_time: the part of search_time spent scoring, summed over threads; only measured with set_instrumentation
+    total_time: the whole call
+    The counters cost an increment on a worker's own context each, and the times a clock read per phase.
+    */
+    struct SearchStats {
+        size_t anchors = 0;
+        size_t anchors_skipped = 0;
+        size_t nodes = 0;
+        size_t duplicates = 0;
+        size_t rack_lookups = 0;
+        size_t candidates = 0;
+        size_t placements_tested = 0;
+        size_t word_checks = 0;
+        size_t words_rejected = 0;
+        std::chrono::nanoseconds lookup_time{0};
+        std::chrono::nanoseconds prepare_time{0};
+        std::chrono::nanoseconds search_time{0};
+        std::chrono::nanoseconds scoring_time{0};
+        std::chrono::nanoseconds total_time{0};
+    };
+
+    const SearchStats& get_search_stats() const;
+
+    /*
+    time_scoring: also measure SearchStats::scoring_time, at two clock reads per move scored
+    log: where get_move writes a line with its SearchStats after every move, or nullptr for nowhere
+    */
+    void set_instrumentation(bool time_scoring, std::ostream* log = nullptr);
+
   private:
+    /*
+    A ranked move plus where the search found it, which breaks ties between equal scores.
+    anchor orders the anchors the way Board::get_anchors lists them, see anchor_rank.
+    */
+    struct Candidate {
+        RankedMove ranked;
+        size_t anchor;
+        size_t order;
+    };
+
+    /*
+    Returns whether a should be listed before b: more equity first, then earlier anchor, then generated earlier
+    */
+    static bool ranks_before(const Candidate& a, const Candidate& b);
+
+    /*
+    The limits of one search, shared by all of its workers. effort is only set for a capped search, which runs on a
+    single worker; capped tells whether an anchor ran out of its nodes, and found whether a valid move turned up.
+    stop, when set, ends the search the moment it is true.
+    */
+    struct Budget {
+        bool timed = false;
+        std::chrono::steady_clock::time_point deadline;
+        size_t nodes = 0;
+        size_t duplicates = 0;
+        std::atomic<size_t> spent{0};
+        std::atomic<bool> exhausted{false};
+        Effort effort;
+        bool capped = false;
+        bool found = false;
+        const std::atomic<bool>* stop = nullptr;
+    };
+
+    /*
+    What a search for the best move prunes with, shared by all of its workers.
+
+    best: the equity of the best move found so far
+    leave: the most any leave of the rack is worth, which every bound adds on top of the points
+    cross_sums: for each empty square, the points of the tiles touching it in the other direction, or -1 if there are
+        none, for words played ACROSS ([0]) and DOWN ([1])
+    pruned: for each anchor, whether any of its search was skipped
+    */
+    struct Bounds {
+        std::atomic<double> best{-std::numeric_limits<double>::infinity()};
+        double leave = 0;
+        std::vector<int> cross_sums[2];
+        std::vector<char> pruned;
+    };
+
+    /*
+    The mutable state of one search. Every worker thread gets its own, so nothing in it needs to be synchronized.
+
+    remaining_tiles: the rack, minus the tiles in the partial move being searched (TRIE engine)
+    counts, kinds: the same rack as a count and a tile per letter, 'a' to 'z' then the blank (GADDAG engine)
+    left, right: the tiles placed left of and including the anchor, nearest first, and right of it (GADDAG engine)
+    cross_checks: for each square, a bit per letter that may go there in the ACROSS ([0]) and DOWN ([1]) directions
+    visit: called with every move the generator finds
+    anchor: the index of the anchor being searched
+    order: how many moves have been found for that anchor so far
+    nodes: the number of generator calls so far
+    anchor_start: what nodes was when the search of the current anchor started
+    duplicates: the number of moves record dropped as the same placement as another move
+    stats: the other counters of SearchStats, for this worker
+    budget: the limits of the search, or nullptr if it has none
+    bounds: what to prune with, or nullptr to search everything
+    */
+    struct SearchContext {
+        TileCollection remaining_tiles;
+        std::vector<size_t> counts;
+        std::vector<TileKind> kinds;
+        std::vector<TileKind> left;
+        std::vector<TileKind> right;
+        Move placement;  // where record_placement puts the tiles of left and right together
+        const std::vector<uint32_t>* cross_checks = nullptr;
+        std::function<void(SearchContext&, const Move&)> visit;
+        size_t anchor = 0;
+        size_t order = 0;
+        size_t nodes = 0;
+        size_t anchor_start = 0;
+        size_t duplicates = 0;
+        SearchStats stats;
+        Budget* budget = nullptr;
+        Bounds* bounds = nullptr;
+        bool prune_blanks = false;
+    };
+
+    /*
+    Sets up a SearchContext holding this player's hand
+    */
+    SearchContext make_context() const;
+
     // The following functions may be modified in any way.
     // e.g. You may decide you'd prefer to pass in a Dictionary reference rather than
     // std::shared_ptr<Dictionary::TrieNode>
@@ -31,26 +543,26 @@ class ComputerPlayer : public Player {
 
     anchor: The board position for the anchor square
     partial_word: the partial word that has already been searched
-    partial_move: the Move object associated with the partial word (has tiles for each letter in partial_word)
+    partial_move: the move associated with the partial word (has tiles for each letter in partial_word), built in
+        place: its row or column is set for the prefix, and every tile pushed onto it is popped again before returning
     node: The node in the Dictionary associated with partial_word
     limit: The max prefix size to consider
-    remaining_tiles: The tiles that can still be used to form a move
-        Passed by reference
-        Tiles should be removed when every searching forward on that tile
-        Tiles should be put back in remaining_tiles when backtracking
-    legal_moves: A vector that accumulates Moves that create a valid word
-        Note: Does not necessarily need to check perpendicular words while searching
-              but it can if you prefer.
+    search: The state of the search
+        search.remaining_tiles holds the tiles that can still be used to form a move
+            Tiles should be removed when every searching forward on that tile
+            Tiles should be put back in remaining_tiles when backtracking
+        Moves that create a valid word are passed to record()
+            Note: Does not necessarily need to check perpendicular words while searching
+                  but it can if you prefer.
     board: a reference to the scrabble board
     */
     void left_part(
             Board::Position anchor_pos,
             std::string partial_word,
-            Move partial_move,
+            Move& partial_move,
             std::shared_ptr<Dictionary::TrieNode> node,
             size_t limit,
-            TileCollection& remaining_tiles,
-            std::vector<Move>& legal_moves,
+            SearchContext& search,
             const Board& board) const;
 
     /*
@@ -59,32 +571,383 @@ class ComputerPlayer : public Player {
 
     square: The board position to search from
     partial_word: the partial word that has already been formed
-    partial_move: the Move object associated with the partial word
+    partial_move: the move associated with the partial word
         (has tiles for each letter in partial_word, unless that tile was already on the board)
     node: The node in the Dictionary associated with partial_word
-    remaining_tiles: The tiles that can still be used to form a move
-        Passed by reference
-        Tiles should be removed when every searching forward on that tile
-        Tiles should be put back in remaining_tiles when backtracking
-    legal_moves: A vector that accumulates Moves that create a valid word
-        Note: Does not necessarily need to check perpendicular words while searching
-              but it can if you prefer.
+    search: The state of the search, see left_part
     board: a reference to the scrabble board
     */
     void extend_right(
             Board::Position square,
             std::string partial_word,
-            Move partial_move,
+            Move& partial_move,
             std::shared_ptr<Dictionary::TrieNode> node,
-            TileCollection& remaining_tiles,
-            std::vector<Move>& legal_moves,
+            SearchContext& search,
             const Board& board) const;
 
     /*
-    Searches the vector of legal moves for the highest scoring move
-    Ties broken arbitrarily
+    Covers square with the next letter of a word that is being grown from anchor through the GADDAG.
+
+    While leftward is true the word grows from the anchor towards the start of the line, otherwise it grows towards the
+    end. A tile already on square has to be used; an empty square is tried with every rack tile that the GADDAG and the
+    square's cross check allow.
+    node: The GADDAG node reached by the letters covered so far
+    */
+    void gaddag_extend(
+            const Board::Anchor& anchor,
+            Board::Position square,
+            Gaddag::Node node,
+            bool leftward,
+            SearchContext& search,
+            const Board& board,
+            const Gaddag& gaddag) const;
+
+    /*
+    Called once square has been covered. Records the move if the word is complete and carries on growing it, turning
+    around at the separator once the left part is done.
+    */
+    void gaddag_advance(
+            const Board::Anchor& anchor,
+            Board::Position square,
+            Gaddag::Node node,
+            bool leftward,
+            SearchContext& search,
+            const Board& board,
+            const Gaddag& gaddag) const;
+
+    /*
+    Fills masks with the cross checks for words played in direction: for every empty square, a bit per letter
+    ('a' is bit 0) that forms a dictionary word with the tiles touching the square in the other direction.
+    Squares with no such tiles allow every letter.
+    */
+    void compute_cross_checks(
+            Direction direction, const Board& board, const Dictionary& dictionary, std::vector<uint32_t>& masks) const;
+
+    /*
+    Returns whether the search has used up its budget. Called once per node by the generators, which return as soon as
+    it is true.
+    */
+    bool out_of_budget(SearchContext& search) const;
+
+    /*
+    Estimates how much a move through anchor could score from the premium squares it can reach, so that a budgeted
+    search looks at the most promising anchors first. Only the order of the search depends on it.
+    */
+    size_t anchor_priority(const Board::Anchor& anchor, const Board& board) const;
+
+    /*
+    Fills sums with Bounds::cross_sums for words played in direction
+    */
+    void compute_cross_sums(Direction direction, const Board& board, std::vector<int>& sums) const;
+
+    /*
+    Returns the most points a move through anchor can score, without looking at the dictionary. Every run of empty
+    squares through the anchor that the rack can fill is shadow played: the rack's best tiles go on the squares where
+    they count the most, in the main word and in the cross words, and the word multipliers of the run apply.
+    The best of these is the bound. With cross_checks, squares no tile on the rack fits end the runs.
+    The bingo bonus is not part of the points moves are ranked by, so it is left out too.
+    */
+    size_t anchor_bound(
+            const Board::Anchor& anchor,
+            const Board& board,
+            const std::vector<int>& cross_sums,
+            const std::vector<uint32_t>* cross_checks) const;
+
+    /*
+    Returns the most points a move can score once its tiles from start up to the square before next are known: the
+    points of those tiles are exact, and the squares the tiles left on the rack can still reach are bounded the way
+    anchor_bound does. The known tiles are those of reversed, last first, followed by those of forward.
+    */
+    size_t placement_bound(
+            Direction direction,
+            Board::Position start,
+            Board::Position next,
+            const std::vector<TileKind>& reversed,
+            const std::vector<TileKind>& forward,
+            const SearchContext& search,
+            const Board& board) const;
+
+    /*
+    Returns whether a partial placement whose points cannot exceed bound should be skipped, and marks its anchor
+    as pruned if so
+    */
+    bool prune(size_t bound, SearchContext& search) const;
+
+    /*
+    Hands a move the generator found to search.visit, unless another anchor produces the same placement.
+
+    Both engines keep every left part clear of other anchors, so a move that places two or more tiles is only ever
+    found from the first anchor it covers. A single tile is the exception: it is found from both the ACROSS and the
+    DOWN anchor on its square, so only the ACROSS one is kept if the tile has a neighbour in that direction, and only
+    the DOWN one otherwise.
+
+    With search.prune_blanks, a move that plays a blank as a letter the rack still holds a real tile of is left out
+    too (see set_blank_pruning).
+    */
+    void record(SearchContext& search, const Move& move, const Board& board) const;
+
+    /*
+    Records the placement the GADDAG engine has built for anchor: the tiles of search.left, last first, followed by
+    those of search.right
+    */
+    void record_placement(const Board::Anchor& anchor, SearchContext& search, const Board& board) const;
+
+    /*
+    Generates the candidate moves for a single anchor using the selected engine and records each of them.
+
+    The TRIE engine calls left_part for anchors with a limit and extend_right from the tiles already on the board
+    otherwise. The rack in search is left the way it was found.
+    */
+    void search_anchor(
+            const Board::Anchor& anchor, SearchContext& search, const Board& board, const Dictionary& dictionary) const;
+
+    /*
+    Runs the selected engine over every anchor, on the thread pool if there is one, and calls visit(search, move) for
+    every move it generates. search.anchor tells visit which anchor the move came from.
+    If budgeted is true the search follows anchor_priority and stops when the budget set by set_budget runs out.
+    With bounds the anchors are searched highest anchor_bound first instead, and both they and the partial placements
+    are skipped once they cannot beat bounds->best, which visit has to keep up to date. On a single thread the search
+    stops at the first anchor it skips, since none of the ones after it can do better.
+    prune_blanks leaves out the moves record drops under blank pruning.
+    Returns the contexts the searches ran in, one per worker.
+    */
+    std::vector<SearchContext> search_anchors(
+            const Board& board,
+            const Dictionary& dictionary,
+            const std::vector<Board::Anchor>& anchors,
+            const std::function<void(SearchContext&, const Move&)>& visit,
+            bool budgeted = false,
+            Bounds* bounds = nullptr,
+            bool prune_blanks = false) const;
+
+    /*
+    Returns whether a search for the best moves prunes blanks, see set_blank_pruning
+    */
+    bool prunes_blanks() const;
+
+    /*
+    Adds a move to heap if it is among the keep best seen so far. The front of heap is the worst move it holds.
+    Moves with the same anchor must be offered in the order they were generated.
     */
-    Move get_best_move(std::vector<Move> legal_moves, const Board& board, const Dictionary& dictionary) const;
+    static void offer(
+            std::vector<Candidate>& heap,
+            size_t keep,
+            const Move& move,
+            PlaceResult& result,
+            double equity,
+            size_t anchor,
+            size_t order);
+
+    /*
+    Returns where anchor comes in the order Board::get_anchors lists anchors in: by row, then column, ACROSS first
+    */
+    static size_t anchor_rank(const Board::Anchor& anchor, const Board& board);
+
+    /*
+    The best moves along one line for one rack, kept from an earlier search
+
+    stamp: the line's stamp when the moves were found, 0 if nothing is cached
+    rack: the rack the moves were found for, see rack_key
+    keep: how many moves were asked for; moves holds fewer if the line has fewer valid moves
+    moves: the keep best moves along the line, best first
+    */
+    struct LineCache {
+        uint64_t stamp = 0;
+        std::string rack;
+        size_t keep = 0;
+        std::vector<Candidate> moves;
+    };
+
+    /*
+    What pondering shares with its background thread. answers maps the hash of a board to our move there, which only
+    holds for the rack and the number of tiles in the bag it was found with. The thread is the only one to touch
+    answers and the thinker until it is joined.
+    */
+    struct Ponder {
+        struct Answer {
+            std::string rack;
+            size_t in_bag;
+            CompactMove move;
+        };
+
+        std::thread thread;
+        std::atomic<bool> stop{false};
+        std::unordered_map<uint64_t, Answer> answers;
+        // the copy of the player pondering runs on, and whether its line cache holds every line of the board; both it
+        // and the answers only hold for the dictionary and settings in context (see ponder_context)
+        std::unique_ptr<ComputerPlayer> thinker;
+        bool warmed = false;
+        uint64_t context = 0;
+    };
+
+    /*
+    The work of start_pondering, run on its thread with the unseen tiles and bag size as they were when it started
+    */
+    void ponder(Ponder& state, Board board, const Dictionary& dictionary, std::vector<TileKind> unseen, size_t in_bag)
+            const;
+
+    /*
+    Returns whether get_move, with in_bag tiles in the bag, picks the best move by equity rather than simulating or
+    solving the endgame or pre-endgame
+    */
+    bool picks_by_equity(size_t in_bag) const;
+
+    /*
+    Picks a move the way get_move does, without pondering, for a bag holding in_bag tiles
+    */
+    Move choose_move(const Board& board, const Dictionary& dictionary, size_t in_bag) const;
+
+    /*
+    Returns the context positions are stored in the transposition cache under: everything besides the board's tiles
+    and the rack that the moves get_top_moves finds depend on. The dictionary and leave table go in by the fingerprints
+    of their contents rather than by address, so the context stays the same for equal copies of them and can never
+    alias a table freed and read again at the same address.
+    */
+    uint64_t cache_context(const Board& board, const Dictionary& dictionary) const;
+
+    /*
+    Returns cache_context with every other setting that decides which move get_move picks folded in: the effort,
+    budget, opening book, simulation, lookahead and endgame settings. Pondering only answers for the same one.
+    */
+    uint64_t ponder_context(const Board& board, const Dictionary& dictionary) const;
+
+    /*
+    Returns the value of keeping tiles by the leave table, or 0 without one
+    */
+    double leave_value(const std::vector<TileKind>& tiles) const;
+
+    /*
+    Returns a string that is the same for two racks exactly when they hold the same tiles
+    */
+    std::string rack_key() const;
+
+    /*
+    Plays out one candidate for simulate: draws come from pool in order, and me and opponent are scratch players
+    whose racks get replaced. Returns the outcome for this player.
+    */
+    double playout(
+            const RankedMove& candidate,
+            const std::vector<TileKind>& pool,
+            const Board& board,
+            const Dictionary& dictionary,
+            ComputerPlayer& me,
+            ComputerPlayer& opponent) const;
+
+    /*
+    Returns every distinct multiset of count tiles that can be drawn from tiles, with the probability of drawing it
+    */
+    static std::vector<std::pair<std::vector<TileKind>, double>>
+    distinct_draws(const std::vector<TileKind>& tiles, size_t count);
+
+    /*
+    Checks that a candidate can be placed and that every word it forms is in the dictionary.
+    Returns the result of Board::test_place, which is not valid if any of the words is missing from the dictionary.
+    Counts the calls in stats, if given.
+    */
+    PlaceResult score_move(
+            const Move& move, const Board& board, const Dictionary& dictionary, SearchStats* stats = nullptr) const;
+
+    std::shared_ptr<WorkStealingPool> pool;
+    Engine engine = Engine::TRIE;
+    std::shared_ptr<const LeaveTable> leaves;
+    std::shared_ptr<const OpeningBook> book;
+    std::shared_ptr<TranspositionCache> transpositions;
+    bool pruning = true;
+    bool blank_pruning = true;
+    std::chrono::milliseconds time_budget{0};
+    size_t node_budget = 0;
+    Effort effort;
+    Effort playout_effort;
+    std::shared_ptr<const Strategy> strategy;
+    // See get_chooser; copies of this player share it
+    mutable std::shared_ptr<ComputerPlayer> chooser;
+    mutable std::vector<LineCache> line_cache[2];  // ACROSS (one per row), DOWN (one per column)
+    mutable const Dictionary* cached_dictionary = nullptr;
+    mutable size_t nodes_visited = 0;
+    mutable size_t duplicates_avoided = 0;
+    mutable size_t anchors_skipped = 0;
+    mutable bool search_complete = true;
+    mutable SearchStats search_stats;
+    bool time_scoring = false;
+    std::ostream* search_log = nullptr;
+    std::vector<TileKind> unseen_tiles;
+    size_t unseen_in_bag = 0;
+    std::chrono::milliseconds endgame_time{0};
+    mutable double pre_endgame_coverage = 0;
+    std::shared_ptr<Ponder> pondering;
+    mutable bool ponder_hit = false;
+    // Set on the copy pondering runs on: every search it makes ends as soon as this is
+    const std::atomic<bool>* interrupt = nullptr;
+    size_t simulation_candidates = 0;
+    size_t simulation_plies = 2;
+    size_t simulation_iterations = 0;
+    uint32_t simulation_seed = 0;
+    mutable double playouts_per_second = 0;
+    size_t lookahead_candidates = 0;
+    size_t lookahead_samples = 0;
+    std::chrono::milliseconds lookahead_time{0};
+    uint32_t lookahead_seed = 0;
+    mutable double lookahead_coverage = 0;
+};
+
+/*
+The GADDAG search of ComputerPlayer as a resumable state machine: instead of recursing, it keeps one Frame per call of
+gaddag_extend and gaddag_advance the recursion would be in, and stops whenever record hands on a move. next picks
+the search up where it stopped. Memory is the anchors and cross checks of the board plus the stack, which never gets
+deeper than the longest word the board fits, however many moves there are.
+*/
+class ComputerPlayer::MoveEnumerator {
+  public:
+    /*
+    Sets move to the next valid move and returns true, or returns false once there are none left
+    */
+    bool next(Move& move);
+
+    // The search nodes visited so far, counted the way get_nodes_visited counts them
+    size_t get_nodes_visited() const;
+
+  private:
+    friend class ComputerPlayer;
+
+    /*
+    One call of gaddag_extend (EXTEND) or gaddag_advance (ADVANCE), and how far it has got (step).
+    edge is the edge gaddag_extend is trying, and index its letter's place on the rack.
+    */
+    struct Frame {
+        enum Kind : uint8_t { EXTEND, ADVANCE };
+        Kind kind;
+        uint8_t step;
+        bool leftward;
+        int8_t index;
+        Board::Position square;
+        Gaddag::Node node;
+        const Gaddag::Edge* edge;
+    };
+
+    /*
+    Everything the search works on, kept in one place so that the search context can point into it while the
+    enumerator itself is moved around
+    */
+    struct State {
+        const ComputerPlayer* player;
+        const Board* board;
+        const Dictionary* dictionary;
+        std::shared_ptr<const Gaddag> gaddag;
+        std::vector<Board::Anchor> anchors;
+        size_t anchor = 0;
+        std::vector<uint32_t> cross_checks[2];
+        SearchContext search;
+        std::vector<Frame> stack;
+        bool recorded = false;
+        Move pending;
+    };
+
+    explicit MoveEnumerator(std::unique_ptr<State> state) : state(std::move(state)) {}
+
+    // Runs the search until record hands on a move or the search is over; returns false in the latter case
+    bool resume();
+
+    std::unique_ptr<State> state;
 };
 
 #endif
@@ -1,6 +1,7 @@
 #include "dictionary.h"
 
 #include "exceptions.h"
+#include "zobrist.h"
 #include <algorithm>
 #include <cctype>
 #include <fstream>
@@ -77,9 +78,20 @@ void Dictionary::add_word(const string& word) {
         }
         cur = cur->nexts.find(letter)->second;
     }
+    if (cur->is_final) {
+        return;
+    }
     cur->is_final = true;
+    // the words are summed up, so the order they come in does not matter
+    uint64_t hash = zobrist_key(word.size());
+    for (char letter : word) {
+        hash = zobrist_key(hash ^ static_cast<unsigned char>(letter));
+    }
+    fingerprint += hash;
 }
 
+void Dictionary::build_gaddag() { gaddag = make_shared<const Gaddag>(Gaddag::build(*this)); }
+
 vector<char> Dictionary::next_letters(const std::string& prefix) const {
     shared_ptr<TrieNode> cur = find_prefix(prefix);
     vector<char> nexts;
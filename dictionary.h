@@ -1,6 +1,8 @@
 #ifndef DICTIONARY_H
 #define DICTIONARY_H
 
+#include "gaddag.h"
+#include <cstdint>
 #include <map>
 #include <memory>
 #include <string>
@@ -53,8 +55,27 @@ class Dictionary {
     */
     std::shared_ptr<TrieNode> find_prefix(const std::string& prefix) const;  // Used for testing
 
+    /*
+    Builds the GADDAG of the words in this dictionary so move generators can use it.
+    Building takes a few seconds, so it only happens when asked for.
+    */
+    void build_gaddag();
+
+    /*
+    Returns the GADDAG built by build_gaddag(), or nullptr if it has not been built
+    */
+    std::shared_ptr<const Gaddag> get_gaddag() const { return gaddag; }
+
+    /*
+    Returns a hash of the words in the dictionary, in any order: two dictionaries with the same words have the same
+    fingerprint, whichever process read them
+    */
+    uint64_t get_fingerprint() const { return fingerprint; }
+
   private:
     std::shared_ptr<TrieNode> root;
+    std::shared_ptr<const Gaddag> gaddag;
+    uint64_t fingerprint = 0;
 
     void add_word(const std::string& word);
 };
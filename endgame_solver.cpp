@@ -0,0 +1,256 @@
+#include "endgame_solver.h"
+
+#include "leave_table.h"
+#include "zobrist.h"
+#include <algorithm>
+#include <climits>
+
+using namespace std;
+
+size_t EndgameSolver::Table::size() const {
+    lock_guard<mutex> guard(lock);
+    return entries.size();
+}
+
+EndgameSolver::EndgameSolver(
+        const Dictionary& dictionary, ComputerPlayer::Engine engine, size_t hand_size, shared_ptr<Table> table)
+        : dictionary(dictionary),
+          hand_size(hand_size),
+          sides{ComputerPlayer("me", hand_size), ComputerPlayer("opponent", hand_size)},
+          table(table != nullptr ? table : make_shared<Table>()) {
+    for (ComputerPlayer& side : sides) {
+        side.set_engine(engine);
+        // every move has to be there for the result to be exact
+        side.set_blank_pruning(false);
+    }
+}
+
+EndgameSolver::Result EndgameSolver::solve(
+        const Board& board,
+        const vector<TileKind>& rack,
+        const vector<TileKind>& opponent_rack,
+        chrono::milliseconds time,
+        const vector<TileKind>& bag) {
+    // the one copy of the board; every node makes and unmakes its moves on it
+    Board position = board;
+    this->board = &position;
+    this->bag = bag;
+    drawn = 0;
+    sides[0].remove_tiles(sides[0].get_tiles());
+    sides[0].add_tiles(rack);
+    sides[1].remove_tiles(sides[1].get_tiles());
+    sides[1].add_tiles(opponent_rack);
+    nodes = 0;
+    stopped = false;
+    deadline = chrono::steady_clock::now() + time;
+
+    Result result;
+    // every turn places a tile or passes, and two passes in a row end the game
+    size_t longest = 2 * (rack.size() + opponent_rack.size() + bag.size()) + 2;
+    for (size_t depth = 1; depth <= longest; depth++) {
+        // the first iteration always finishes, so there is a move to return
+        timed = depth > 1 && time.count() > 0;
+        depth_cut = false;
+        int spread = search(0, depth, -INT_MAX, INT_MAX, false);
+        if (stopped) {
+            break;
+        }
+        result.spread = spread;
+        result.depth = depth;
+        result.solved = !depth_cut;
+
+        // follow the best moves through the table
+        result.sequence.clear();
+        vector<size_t> drew;
+        size_t mover = 0;
+        bool passed = false;
+        while (result.sequence.size() < depth) {
+            size_t best;
+            {
+                lock_guard<mutex> guard(table->lock);
+                auto found = table->entries.find(position_key(mover, passed));
+                if (found == table->entries.end()) {
+                    break;
+                }
+                best = found->second.best;
+            }
+            vector<ComputerPlayer::RankedMove> moves = moves_for(mover);
+            if (best >= moves.size()) {
+                result.sequence.push_back(Move());
+                drew.push_back(0);
+                if (passed) {
+                    break;
+                }
+                passed = true;
+            } else {
+                result.sequence.push_back(moves[best].move);
+                drew.push_back(play(mover, moves[best].move));
+                passed = false;
+                if (sides[mover].count_tiles() == 0) {
+                    break;
+                }
+            }
+            mover = 1 - mover;
+        }
+        // take the line back, last move first
+        for (size_t i = result.sequence.size(); i-- > 0;) {
+            if (result.sequence[i].kind == MoveKind::PLACE) {
+                take_back(i % 2, result.sequence[i], drew[i]);
+            }
+        }
+
+        if (result.solved) {
+            break;
+        }
+    }
+    result.nodes = nodes;
+    this->board = nullptr;
+    return result;
+}
+
+int EndgameSolver::search(size_t mover, size_t depth, int alpha, int beta, bool passed) {
+    nodes++;
+    if (timed && chrono::steady_clock::now() >= deadline) {
+        stopped = true;
+    }
+    if (stopped) {
+        return 0;
+    }
+    ComputerPlayer& me = sides[mover];
+    ComputerPlayer& other = sides[1 - mover];
+    int my_rack = me.get_hand_value();
+    int other_rack = other.get_hand_value();
+
+    // the other side went out: we lose our rack and they gain it
+    if (other.count_tiles() == 0) {
+        return -2 * my_rack;
+    }
+    if (depth == 0) {
+        // guess that the game ends here as if both passed
+        depth_cut = true;
+        return other_rack - my_rack;
+    }
+
+    uint64_t key = position_key(mover, passed);
+    size_t first = SIZE_MAX;
+    {
+        lock_guard<mutex> guard(table->lock);
+        auto found = table->entries.find(key);
+        if (found != table->entries.end()) {
+            const Table::Entry& entry = found->second;
+            if (entry.depth >= depth || entry.exact) {
+                if (entry.bound == Table::Bound::EXACT || (entry.bound == Table::Bound::LOWER && entry.value >= beta)
+                    || (entry.bound == Table::Bound::UPPER && entry.value <= alpha)) {
+                    if (!entry.exact) {
+                        depth_cut = true;
+                    }
+                    return entry.value;
+                }
+            }
+            first = entry.best;
+        }
+    }
+
+    // best score first, but the best move of an earlier search of this position before everything else
+    vector<ComputerPlayer::RankedMove> moves = moves_for(mover);
+    vector<size_t> order;
+    if (first <= moves.size()) {
+        order.push_back(first);
+    }
+    for (size_t i = 0; i <= moves.size(); i++) {
+        if (i != first) {
+            order.push_back(i);
+        }
+    }
+
+    int original_alpha = alpha;
+    int best = -INT_MAX;
+    size_t best_index = moves.size();
+    bool outer_cut = depth_cut;
+    depth_cut = false;
+    for (size_t i = 0; i < order.size(); i++) {
+        int value;
+        if (order[i] == moves.size()) {
+            // a second pass in a row ends the game
+            value = passed ? other_rack - my_rack : -search(1 - mover, depth - 1, -beta, -alpha, true);
+        } else {
+            const Move& move = moves[order[i]].move;
+            size_t drew = play(mover, move);
+            value = move_points(moves[order[i]]) - search(1 - mover, depth - 1, -beta, -alpha, false);
+            take_back(mover, move, drew);
+        }
+        if (stopped) {
+            return 0;
+        }
+        if (value > best) {
+            best = value;
+            best_index = order[i];
+        }
+        alpha = max(alpha, value);
+        if (alpha >= beta) {
+            break;
+        }
+    }
+
+    bool exact = !depth_cut;
+    depth_cut = outer_cut || depth_cut;
+    Table::Bound bound = best <= original_alpha ? Table::Bound::UPPER
+                         : best >= beta         ? Table::Bound::LOWER
+                                                : Table::Bound::EXACT;
+    lock_guard<mutex> guard(table->lock);
+    if (table->entries.size() >= MAX_TABLE_SIZE) {
+        table->entries.clear();
+    }
+    table->entries[key] = Table::Entry{best, depth, bound, best_index, exact};
+    return best;
+}
+
+size_t EndgameSolver::play(size_t mover, const Move& move) {
+    board->place(move);
+    sides[mover].remove_tiles(move.tiles);
+    size_t drew = min(move.tiles.size(), bag.size() - drawn);
+    sides[mover].add_tiles(vector<TileKind>(bag.begin() + drawn, bag.begin() + drawn + drew));
+    drawn += drew;
+    return drew;
+}
+
+void EndgameSolver::take_back(size_t mover, const Move& move, size_t drew) {
+    drawn -= drew;
+    sides[mover].remove_tiles(vector<TileKind>(bag.begin() + drawn, bag.begin() + drawn + drew));
+    sides[mover].add_tiles(move.tiles);
+    board->undo_place();
+}
+
+vector<ComputerPlayer::RankedMove> EndgameSolver::moves_for(size_t mover) const {
+    return sides[mover].get_top_moves(*board, dictionary, SIZE_MAX);
+}
+
+uint64_t EndgameSolver::position_key(size_t mover, bool passed) const {
+    uint64_t key = board->get_hash() ^ rack_hash(sides[mover], 1) ^ rack_hash(sides[1 - mover], 2);
+    // the bag by position from its current front, so equal remainders hash the same
+    for (size_t i = drawn; i < bag.size(); i++) {
+        int index = LeaveTable::tile_index(bag[i].letter);
+        key ^= zobrist_key((uint64_t(3) << 32) + (i - drawn) * 64 + index + 1);
+    }
+    return key ^ (passed ? zobrist_key(0) : 0);
+}
+
+uint64_t EndgameSolver::rack_hash(const ComputerPlayer& side, uint64_t salt) const {
+    // one key per (tile, how many of it), so equal racks hash the same in any order
+    size_t counts[LeaveTable::TILE_KINDS] = {};
+    uint64_t hash = 0;
+    vector<TileKind> tiles = side.get_tiles();
+    for (size_t i = 0; i < tiles.size(); i++) {
+        int index = LeaveTable::tile_index(tiles[i].letter);
+        if (index < 0) {
+            continue;
+        }
+        counts[index]++;
+        hash ^= zobrist_key((salt << 32) + index * 64 + counts[index]);
+    }
+    return hash;
+}
+
+int EndgameSolver::move_points(const ComputerPlayer::RankedMove& move) const {
+    return move.points + (move.move.tiles.size() == hand_size ? ComputerPlayer::BINGO_BONUS : 0);
+}
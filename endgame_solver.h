@@ -0,0 +1,152 @@
+#ifndef ENDGAME_SOLVER_H
+#define ENDGAME_SOLVER_H
+
+#include "board.h"
+#include "computer_player.h"
+#include "dictionary.h"
+#include "move.h"
+#include "tile_kind.h"
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+/*
+Plays out the end of a two player game once the bag is empty. Both racks are known then, so the rest of the game is a
+perfect-information search.
+
+The search is negamax with alpha-beta pruning, deepened one turn at a time until it either proves the result or runs
+out of time. Moves are tried best score first, after the best move an earlier iteration found, and positions are
+remembered in a transposition table keyed by the Zobrist hash of the board and both racks. Moves are made and taken
+back on a single board with Board::place and Board::undo_place.
+
+The game ends when a player goes out, or when both players pass in a row. Like Scrabble::final_subtraction, everyone
+then loses the points left on their rack, and a player who went out gains the points left on the other rack.
+
+A bag whose order is known can be given as well, for the pre-endgame: a player who places tiles then draws that many
+from its front, and nobody can go out until it is empty.
+*/
+class EndgameSolver {
+  public:
+    /*
+    sequence: the best line of play found, starting with our move; a PASS move stands for passing
+    spread: our points minus the opponent's over the rest of the game if both follow sequence, penalties included
+    depth: how many turns deep the last finished iteration searched
+    solved: whether spread is exact, rather than cut off by the depth or the time
+    nodes: positions searched over all iterations
+    */
+    struct Result {
+        std::vector<Move> sequence;
+        int spread = 0;
+        size_t depth = 0;
+        bool solved = false;
+        size_t nodes = 0;
+    };
+
+    /*
+    A transposition table. Its keys cover the whole position, bag included, so one table can serve any number of
+    solves and solvers, on any number of threads.
+    */
+    class Table {
+      public:
+        size_t size() const;
+
+      private:
+        friend class EndgameSolver;
+
+        enum class Bound { EXACT, LOWER, UPPER };
+
+        /*
+        A position searched before. best is the index of the best move in the order the generator lists the moves,
+        moves.size() for passing. exact means nothing under it was cut off by the depth.
+        */
+        struct Entry {
+            int value;
+            size_t depth;
+            Bound bound;
+            size_t best;
+            bool exact;
+        };
+
+        mutable std::mutex lock;
+        std::unordered_map<uint64_t, Entry> entries;
+    };
+
+    // A table that grows past this many positions is cleared
+    static const size_t MAX_TABLE_SIZE = 1 << 20;
+
+    /*
+    table is the transposition table to use; without one the solver makes its own, kept from one solve to the next.
+    */
+    EndgameSolver(
+            const Dictionary& dictionary,
+            ComputerPlayer::Engine engine,
+            size_t hand_size,
+            std::shared_ptr<Table> table = nullptr);
+
+    /*
+    Finds the best play for the player holding rack against an opponent holding opponent_rack, with us to move.
+    bag is drawn from front to back. Zero time searches until the result is exact.
+    The result of the deepest iteration that finished within time is returned; the first iteration always finishes.
+    */
+    Result solve(
+            const Board& board,
+            const std::vector<TileKind>& rack,
+            const std::vector<TileKind>& opponent_rack,
+            std::chrono::milliseconds time,
+            const std::vector<TileKind>& bag = std::vector<TileKind>());
+
+  private:
+    const Dictionary& dictionary;
+    size_t hand_size;
+    ComputerPlayer sides[2];
+    std::shared_ptr<Table> table;
+    Board* board = nullptr;
+    std::vector<TileKind> bag;
+    size_t drawn = 0;
+    std::chrono::steady_clock::time_point deadline;
+    bool timed = false;
+    bool stopped = false;
+    bool depth_cut = false;
+    size_t nodes = 0;
+
+    /*
+    Returns the best spread the side to move can get from here over the other side, searching depth more turns.
+    passed is whether the last turn was a pass. Sets stopped and returns 0 once the time is up.
+    */
+    int search(size_t mover, size_t depth, int alpha, int beta, bool passed);
+
+    /*
+    Plays a move for mover on the board and draws its replacements from the bag. Returns how many tiles it drew.
+    */
+    size_t play(size_t mover, const Move& move);
+
+    /*
+    Takes back the last move, which was played by mover and drew `drew` tiles
+    */
+    void take_back(size_t mover, const Move& move, size_t drew);
+
+    /*
+    Returns the moves of the side to move, best score first
+    */
+    std::vector<ComputerPlayer::RankedMove> moves_for(size_t mover) const;
+
+    /*
+    Returns the key of the current position with mover to move, the rest of the bag included
+    */
+    uint64_t position_key(size_t mover, bool passed) const;
+
+    /*
+    Returns the Zobrist hash of a side's rack. salt keeps the racks of the side to move and the other side apart.
+    */
+    uint64_t rack_hash(const ComputerPlayer& side, uint64_t salt) const;
+
+    /*
+    Returns the points of a move, bingo included
+    */
+    int move_points(const ComputerPlayer::RankedMove& move) const;
+};
+
+#endif
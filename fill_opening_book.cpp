@@ -0,0 +1,169 @@
+#include "board.h"
+#include "computer_player.h"
+#include "dictionary.h"
+#include "leave_table.h"
+#include "opening_book.h"
+#include "scrabble_config.h"
+#include "tile_bag.h"
+#include "work_stealing_pool.h"
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+// Racks are filled in chunks of this many, and the book is written after every chunk so a long run can be resumed
+const size_t CHUNK = 5000;
+
+// A rack, as its letters in order, and how many ways there are to draw it from a full bag
+struct Rack {
+    string letters;
+    double ways;
+};
+
+// Every distinct rack of size tiles the bag can deal
+void enumerate_racks(
+        const vector<TileKind>& kinds,
+        const vector<size_t>& available,
+        size_t kind,
+        size_t size,
+        Rack& rack,
+        vector<Rack>& racks) {
+    if (rack.letters.size() == size) {
+        racks.push_back(rack);
+        return;
+    }
+    if (kind == kinds.size()) {
+        return;
+    }
+    // with k of this kind out of n, times C(n, k) ways
+    Rack before = rack;
+    double choose = 1;
+    for (size_t k = 0; k <= available[kind] && rack.letters.size() <= size; k++) {
+        rack.ways = before.ways * choose;
+        enumerate_racks(kinds, available, kind + 1, size, rack, racks);
+        choose = choose * (available[kind] - k) / (k + 1);
+        rack.letters.push_back(kinds[kind].letter);
+    }
+    rack = before;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 3) {
+        cerr << "Usage: " << argv[0] << " <configuration file> <opening book file> [racks] [moves per rack]" << endl;
+        cerr << "Fills the book with the most likely racks first; 0 racks, the default, fills every rack." << endl;
+        return 1;
+    }
+    string book_path = argv[2];
+    size_t limit = argc > 3 ? stoul(argv[3]) : 0;
+    size_t keep = argc > 4 ? stoul(argv[4]) : 1;
+
+    ScrabbleConfig config;
+    Dictionary dictionary;
+    shared_ptr<LeaveTable> leaves;
+    try {
+        config = ScrabbleConfig::read(argv[1]);
+        dictionary = Dictionary::read(config.dictionary_file_path);
+        if (!config.leaves_file_path.empty()) {
+            leaves = make_shared<LeaveTable>(LeaveTable::read(config.leaves_file_path));
+        }
+    } catch (const FileException& e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+    Board board = Board::read(config.board_file_path);
+    TileBag bag = TileBag::read(config.tile_bag_file_path, config.seed);
+    ComputerPlayer::Engine engine = ComputerPlayer::Engine::TRIE;
+    if (config.engine == "gaddag") {
+        dictionary.build_gaddag();
+        engine = ComputerPlayer::Engine::GADDAG;
+    }
+
+    // a book from an earlier run is carried on with, if it is for the same board and as many moves per rack
+    OpeningBook book(board, keep);
+    if (ifstream(book_path)) {
+        try {
+            OpeningBook earlier = OpeningBook::read(book_path);
+            if (earlier.get_keep() == keep && earlier.get_fingerprint() == OpeningBook::fingerprint(board)) {
+                book = earlier;
+            }
+        } catch (const FileException& e) {
+            cerr << e.what() << endl;
+            return 1;
+        }
+    }
+
+    vector<TileKind> kinds;
+    vector<size_t> available;
+    vector<TileKind> tiles;
+    for (auto it = bag.cbegin(); it != bag.cend(); ++it) {
+        tiles.push_back(*it);
+    }
+    sort(tiles.begin(), tiles.end());
+    for (const TileKind& tile : tiles) {
+        if (kinds.empty() || kinds.back().letter != tile.letter) {
+            kinds.push_back(tile);
+            available.push_back(0);
+        }
+        available.back()++;
+    }
+    auto tiles_of = [&kinds](const string& letters) {
+        vector<TileKind> rack_tiles;
+        for (char letter : letters) {
+            rack_tiles.push_back(*find_if(
+                    kinds.begin(), kinds.end(), [letter](const TileKind& kind) { return kind.letter == letter; }));
+        }
+        return rack_tiles;
+    };
+
+    vector<Rack> racks;
+    Rack rack{string(), 1};
+    enumerate_racks(kinds, available, 0, config.hand_size, rack, racks);
+    stable_sort(racks.begin(), racks.end(), [](const Rack& a, const Rack& b) { return a.ways > b.ways; });
+    if (limit > 0 && limit < racks.size()) {
+        racks.resize(limit);
+    }
+    racks.erase(
+            remove_if(racks.begin(), racks.end(), [&](const Rack& r) { return book.contains(tiles_of(r.letters)); }),
+            racks.end());
+    cout << racks.size() << " racks to fill, " << book.size() << " already in the book" << endl;
+
+    // every worker has a player of its own
+    WorkStealingPool pool(thread::hardware_concurrency());
+    vector<ComputerPlayer> players(pool.size(), ComputerPlayer("book", config.hand_size));
+    for (ComputerPlayer& player : players) {
+        player.set_engine(engine);
+        player.set_leave_table(leaves);
+    }
+
+    auto start = chrono::steady_clock::now();
+    for (size_t first = 0; first < racks.size(); first += CHUNK) {
+        size_t count = min(CHUNK, racks.size() - first);
+        vector<vector<Move>> moves(count);
+        pool.run(count, [&](size_t worker, size_t index) {
+            ComputerPlayer& player = players[worker];
+            player.remove_tiles(player.get_tiles());
+            player.add_tiles(tiles_of(racks[first + index].letters));
+            for (const ComputerPlayer::RankedMove& ranked : player.get_top_moves(board, dictionary, keep)) {
+                moves[index].push_back(ranked.move);
+            }
+        });
+        for (size_t i = 0; i < count; i++) {
+            book.add(tiles_of(racks[first + i].letters), moves[i]);
+        }
+        try {
+            book.write(book_path);
+        } catch (const FileException& e) {
+            cerr << e.what() << endl;
+            return 1;
+        }
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        cout << first + count << " of " << racks.size() << " racks in " << seconds << " s" << endl;
+    }
+    return 0;
+}
@@ -0,0 +1,109 @@
+#include "gaddag.h"
+
+#include "dictionary.h"
+#include <algorithm>
+#include <unordered_map>
+
+using namespace std;
+
+namespace {
+
+// A node on the path of the most recently added string. It can still gain edges, so it is not in the graph yet.
+struct OpenNode {
+    bool final = false;
+    vector<Gaddag::Edge> edges;
+};
+
+void collect_words(const shared_ptr<Dictionary::TrieNode>& node, string& word, vector<string>& words) {
+    if (node->is_final) {
+        words.push_back(word);
+    }
+    for (auto it = node->nexts.begin(); it != node->nexts.end(); it++) {
+        word.push_back(it->first);
+        collect_words(it->second, word, words);
+        word.pop_back();
+    }
+}
+
+}  // namespace
+
+Gaddag Gaddag::build(const Dictionary& dictionary) {
+    vector<string> words;
+    string word;
+    collect_words(dictionary.get_root(), word, words);
+
+    // every split of every word: rev(prefix) + SEPARATOR + suffix, with a non-empty prefix
+    vector<string> paths;
+    for (size_t i = 0; i < words.size(); i++) {
+        for (size_t split = 1; split <= words[i].size(); split++) {
+            string path(words[i].rend() - split, words[i].rend());
+            path.push_back(SEPARATOR);
+            path.append(words[i], split, string::npos);
+            paths.push_back(path);
+        }
+    }
+    sort(paths.begin(), paths.end());
+    paths.erase(unique(paths.begin(), paths.end()), paths.end());
+
+    // Incremental construction of a minimal automaton from sorted input (Daciuk et al.).
+    // Once a node falls off the path of the current string it can never change again, so it is either merged with
+    // an identical node that is already in the graph or added to the graph as a new node.
+    Gaddag gaddag;
+    unordered_map<string, Node> registry;
+    auto freeze = [&gaddag, &registry](const OpenNode& open) {
+        string signature(1, open.final ? '1' : '0');
+        for (size_t i = 0; i < open.edges.size(); i++) {
+            signature.push_back(open.edges[i].letter);
+            signature.append(reinterpret_cast<const char*>(&open.edges[i].target), sizeof(Node));
+        }
+        auto found = registry.find(signature);
+        if (found != registry.end()) {
+            return found->second;
+        }
+        Node id = gaddag.nodes.size();
+        gaddag.nodes.push_back({static_cast<uint32_t>(gaddag.edges.size()),
+                                static_cast<uint16_t>(open.edges.size()),
+                                open.final});
+        gaddag.edges.insert(gaddag.edges.end(), open.edges.begin(), open.edges.end());
+        registry.emplace(signature, id);
+        return id;
+    };
+
+    vector<OpenNode> path(1);
+    string previous;
+    for (size_t i = 0; i < paths.size(); i++) {
+        const string& current = paths[i];
+        size_t common = 0;
+        while (common < previous.size() && common < current.size() && previous[common] == current[common]) {
+            common++;
+        }
+        // close the part of the previous path that the current string does not share
+        while (path.size() > common + 1) {
+            Node id = freeze(path.back());
+            path.pop_back();
+            path.back().edges.push_back({previous[path.size() - 1], id});
+        }
+        for (size_t j = common; j < current.size(); j++) {
+            path.emplace_back();
+        }
+        path.back().final = true;
+        previous = current;
+    }
+    while (path.size() > 1) {
+        Node id = freeze(path.back());
+        path.pop_back();
+        path.back().edges.push_back({previous[path.size() - 1], id});
+    }
+    gaddag.root_node = freeze(path.back());
+
+    return gaddag;
+}
+
+Gaddag::Node Gaddag::child(Node node, char letter) const {
+    for (const Edge* edge = edges_begin(node); edge != edges_end(node); edge++) {
+        if (edge->letter == letter) {
+            return edge->target;
+        }
+    }
+    return NONE;
+}
@@ -0,0 +1,71 @@
+#ifndef GADDAG_H
+#define GADDAG_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class Dictionary;
+
+/*
+A GADDAG holds every word of a dictionary once for each way of splitting it into a reversed prefix and a suffix:
+    rev(prefix) + SEPARATOR + suffix
+
+Starting from any letter of a word you can walk left through the reversed prefix, cross the separator and then walk
+right through the suffix, which lets a move generator grow words outward from an anchor square in both directions.
+
+The graph is minimized while it is built and stored in two flat arrays, so the whole English dictionary fits in a
+few megabytes and walking it never touches the heap.
+*/
+class Gaddag {
+  public:
+    typedef uint32_t Node;
+
+    struct Edge {
+        char letter;
+        Node target;
+    };
+
+    static const char SEPARATOR = '^';
+    static const Node NONE = UINT32_MAX;
+
+    /*
+    Builds the GADDAG for every word in the dictionary
+    */
+    static Gaddag build(const Dictionary& dictionary);
+
+    Node root() const { return root_node; }
+
+    /*
+    Returns the node reached by following letter out of node, or NONE if there is no such edge
+    */
+    Node child(Node node, char letter) const;
+
+    /*
+    Returns whether the path that ends at node spells a complete word
+    */
+    bool is_final(Node node) const { return nodes[node].final; }
+
+    /*
+    The outgoing edges of node are edges_begin(node) up to edges_end(node), sorted by letter
+    */
+    const Edge* edges_begin(Node node) const { return edges.data() + nodes[node].first_edge; }
+    const Edge* edges_end(Node node) const { return edges.data() + nodes[node].first_edge + nodes[node].edge_count; }
+
+    size_t node_count() const { return nodes.size(); }
+    size_t edge_count() const { return edges.size(); }
+
+  private:
+    struct NodeData {
+        uint32_t first_edge;
+        uint16_t edge_count;
+        bool final;
+    };
+
+    std::vector<NodeData> nodes;
+    std::vector<Edge> edges;
+    Node root_node = NONE;
+};
+
+#endif
@@ -0,0 +1,208 @@
+#include "board.h"
+#include "computer_player.h"
+#include "dictionary.h"
+#include "exceptions.h"
+#include "leave_table.h"
+#include "scrabble_config.h"
+#include "strategy.h"
+#include "tile_bag.h"
+#include <algorithm>
+#include <ctime>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// What one strategy did over all the games it played
+struct Tally {
+    double wins = 0;  // a tie counts half
+    long spread = 0;  // its points minus the other strategy's, summed over the games
+    size_t moves = 0;
+    double cpu_ms = 0;
+};
+
+// The strategy a name on the command line stands for, set up from the configuration; nullptr for an unknown name
+shared_ptr<const Strategy> make_strategy(
+        const string& name, const ScrabbleConfig& config, shared_ptr<const LeaveTable> leaves) {
+    if (name == "greedy") {
+        return make_shared<GreedyStrategy>();
+    } else if (name == "equity") {
+        return make_shared<EquityStrategy>(leaves);
+    } else if (name == "capped") {
+        ComputerPlayer::Effort effort;
+        effort.anchor_nodes = config.fast_anchor_nodes;
+        effort.good_enough = config.fast_good_enough;
+        effort.greedy = config.fast_greedy;
+        return make_shared<CappedStrategy>(effort, leaves);
+    } else if (name == "simulation") {
+        // candidates, plies and iterations default to something that plays a game in reasonable time
+        size_t candidates = config.simulation_candidates > 0 ? config.simulation_candidates : 5;
+        return make_shared<SimulationStrategy>(
+                leaves, candidates, config.simulation_plies, config.simulation_iterations, config.seed);
+    }
+    return nullptr;
+}
+
+// Every tile player cannot see: the bag and the other players' racks
+vector<TileKind> unseen_tiles(const TileBag& bag, const vector<ComputerPlayer>& players, size_t player) {
+    vector<TileKind> unseen;
+    for (auto it = bag.cbegin(); it != bag.cend(); ++it) {
+        unseen.push_back(*it);
+    }
+    for (size_t i = 0; i < players.size(); i++) {
+        if (i != player) {
+            vector<TileKind> rack = players[i].get_tiles();
+            unseen.insert(unseen.end(), rack.begin(), rack.end());
+        }
+    }
+    return unseen;
+}
+
+/*
+Plays one game between the players from the bag seeded with seed. The game ends as soon as a player runs out of
+tiles, or once 2 * players turns in a row have scored nothing, whether passes, exchanges or placements worth no points.
+Adds each player's moves and CPU time to tallies, and returns their final points, hand values subtracted and the
+total added for a player who went out, as Scrabble::final_subtraction does.
+*/
+vector<long> play_game(
+        const ScrabbleConfig& config,
+        const Dictionary& dictionary,
+        vector<ComputerPlayer>& players,
+        uint32_t seed,
+        vector<Tally*> tallies) {
+    Board board = Board::read(config.board_file_path);
+    board.minimum_word_length = config.minimum_word_length;
+    TileBag bag = TileBag::read(config.tile_bag_file_path, seed);
+    for (ComputerPlayer& player : players) {
+        player.add_tiles(bag.remove_random_tiles(min(config.hand_size, bag.count_tiles())));
+    }
+
+    vector<long> points(players.size(), 0);
+    size_t scoreless = 0;
+    for (size_t i = 0; scoreless < 2 * players.size(); i = (i + 1) % players.size()) {
+        ComputerPlayer& player = players[i];
+        player.set_unseen_tiles(unseen_tiles(bag, players, i), bag.count_tiles());
+
+        clock_t start = clock();
+        Move move = player.get_move(board, dictionary);
+        tallies[i]->cpu_ms += 1000.0 * (clock() - start) / CLOCKS_PER_SEC;
+        tallies[i]->moves++;
+
+        if (move.kind == MoveKind::PLACE) {
+            PlaceResult placed = board.place(move);
+            points[i] += placed.points + (move.tiles.size() == config.hand_size ? 50 : 0);
+            player.remove_tiles(move.tiles);
+            player.add_tiles(bag.remove_random_tiles(min(move.tiles.size(), bag.count_tiles())));
+            scoreless = placed.points > 0 ? 0 : scoreless + 1;
+        } else if (move.kind == MoveKind::EXCHANGE) {
+            player.remove_tiles(move.tiles);
+            for (const TileKind& tile : move.tiles) {
+                bag.add_tile(tile);
+            }
+            player.add_tiles(bag.remove_random_tiles(move.tiles.size()));
+            scoreless++;
+        } else {
+            scoreless++;
+        }
+        if (player.count_tiles() == 0) {
+            break;
+        }
+    }
+
+    // the final subtraction of Scrabble::final_subtraction
+    long hands = 0;
+    for (size_t i = 0; i < players.size(); i++) {
+        points[i] -= players[i].get_hand_value();
+        hands += players[i].get_hand_value();
+    }
+    for (size_t i = 0; i < players.size(); i++) {
+        if (players[i].count_tiles() == 0) {
+            points[i] += hands;
+        }
+    }
+    return points;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 4) {
+        cerr << "Usage: " << argv[0] << " <configuration file> <strategy a> <strategy b> [pairs]" << endl;
+        cerr << "Strategies: greedy, equity, capped, simulation" << endl;
+        return 1;
+    }
+    size_t pairs = argc > 4 ? stoul(argv[4]) : 10;
+
+    ScrabbleConfig config;
+    Dictionary dictionary;
+    shared_ptr<const LeaveTable> leaves;
+    try {
+        config = ScrabbleConfig::read(argv[1]);
+        dictionary = Dictionary::read(config.dictionary_file_path);
+        if (!config.leaves_file_path.empty()) {
+            leaves = make_shared<LeaveTable>(LeaveTable::read(config.leaves_file_path));
+        }
+    } catch (const FileException& e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+    ComputerPlayer::Engine engine = ComputerPlayer::Engine::TRIE;
+    if (config.engine == "gaddag") {
+        dictionary.build_gaddag();
+        engine = ComputerPlayer::Engine::GADDAG;
+    }
+
+    shared_ptr<const Strategy> strategies[2];
+    for (size_t s = 0; s < 2; s++) {
+        strategies[s] = make_strategy(argv[2 + s], config, leaves);
+        if (strategies[s] == nullptr) {
+            cerr << "Unknown strategy: " << argv[2 + s] << endl;
+            return 1;
+        }
+    }
+    if (leaves == nullptr) {
+        cerr << "No leave table configured: equity, capped and simulation rank moves by points alone" << endl;
+    }
+
+    // every pair of games draws from the same bag twice, the strategies taking turns to go first, so neither gets the
+    // better tiles or the first move more often than the other
+    Tally tallies[2];
+    for (size_t pair = 0; pair < pairs; pair++) {
+        for (size_t first = 0; first < 2; first++) {
+            size_t seats[2] = {first, 1 - first};  // the strategy in each seat
+            vector<ComputerPlayer> players;
+            vector<Tally*> seat_tallies;
+            for (size_t seat = 0; seat < 2; seat++) {
+                players.emplace_back(strategies[seats[seat]]->get_name(), config.hand_size);
+                players.back().set_engine(engine);
+                players.back().set_threads(1);
+                players.back().set_strategy(strategies[seats[seat]]);
+                seat_tallies.push_back(&tallies[seats[seat]]);
+            }
+            vector<long> points = play_game(config, dictionary, players, config.seed + pair, seat_tallies);
+
+            long a = points[first == 0 ? 0 : 1];
+            long b = points[first == 0 ? 1 : 0];
+            tallies[0].wins += a > b ? 1 : a == b ? 0.5 : 0;
+            tallies[1].wins += b > a ? 1 : a == b ? 0.5 : 0;
+            tallies[0].spread += a - b;
+            tallies[1].spread += b - a;
+            cout << "pair " << setw(3) << pair + 1 << ", " << strategies[0]->get_name()
+                 << (first == 0 ? " first" : " second") << ": " << a << " - " << b << endl;
+        }
+    }
+
+    size_t games = 2 * pairs;
+    cout << endl
+         << setw(12) << "strategy" << setw(10) << "win rate" << setw(10) << "spread" << setw(8) << "moves" << setw(12)
+         << "cpu ms/move" << endl;
+    for (size_t s = 0; s < 2; s++) {
+        const Tally& tally = tallies[s];
+        cout << setw(12) << strategies[s]->get_name() << fixed << setprecision(3) << setw(10)
+             << (games > 0 ? tally.wins / games : 0) << setprecision(1) << setw(10)
+             << (games > 0 ? double(tally.spread) / games : 0) << setw(8) << tally.moves << setprecision(2) << setw(12)
+             << (tally.moves > 0 ? tally.cpu_ms / tally.moves : 0) << endl;
+    }
+    return 0;
+}
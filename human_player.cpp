@@ -7,6 +7,7 @@
 #include "rang.h"
 #include "tile_kind.h"
 #include <algorithm>
+#include <chrono>
 #include <iomanip>
 #include <iostream>
 #include <map>
@@ -22,6 +23,20 @@ inline string& to_upper(string& str) {
     return str;
 }
 
+// The PLACE command that plays move
+static string command_for(const Move& move) {
+    ostringstream command;
+    command << "PLACE " << (move.direction == Direction::DOWN ? '|' : '-') << " " << move.row + 1 << " "
+            << move.column + 1 << " ";
+    for (const TileKind& tile : move.tiles) {
+        command << tile.letter;
+        if (tile.letter == TileKind::BLANK_LETTER) {
+            command << tile.assigned;
+        }
+    }
+    return command.str();
+}
+
 Move HumanPlayer::get_move(const Board& board, const Dictionary& dictionary) const {
     print_hand(cout);
     // keep asking for player's move until the move is valid
@@ -34,6 +49,27 @@ Move HumanPlayer::get_move(const Board& board, const Dictionary& dictionary) con
         if (move == "PASS") {
             return Move();
         }
+        if (move == "HINT") {
+            if (hinter == nullptr) {
+                cout << "No hints in this game" << endl;
+                continue;
+            }
+            auto start = chrono::steady_clock::now();
+            vector<ComputerPlayer::RankedMove> hints = get_hints(board, dictionary);
+            double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+            for (const ComputerPlayer::RankedMove& hint : hints) {
+                cout << "  " << command_for(hint.move) << "  (" << hint.points << " points)" << endl;
+            }
+            if (hints.empty()) {
+                cout << "No moves found, try EXCHANGE or PASS" << endl;
+            }
+            cout << fixed << setprecision(1) << "  found in " << ms << " ms"
+                 << (hinter->get_search_complete() ? "" : ", out of time before every move was tried") << "; p50 "
+                 << hint_latency.percentile(0.5).count() / 1000.0 << " ms, p99 "
+                 << hint_latency.percentile(0.99).count() / 1000.0 << " ms over " << hint_latency.count()
+                 << " hints" << endl;
+            continue;
+        }
         if (move == "EXCHANGE") {
             cin >> move;
             std::vector<TileKind> movetiles;
@@ -183,3 +219,25 @@ void HumanPlayer::print_hand(ostream& out) const {
     print_horizontal(tile_count, L_BOTTOM_LEFT, T_UP, L_BOTTOM_RIGHT, out);
     out << repeat(SPACE, empty_tile_width) << rang::style::reset << endl;
 }
+
+void HumanPlayer::set_hints(shared_ptr<ComputerPlayer> engine, size_t count, chrono::milliseconds time) {
+    hinter = engine;
+    hint_count = count;
+    if (hinter != nullptr) {
+        hinter->set_budget(time, 0);
+    }
+}
+
+vector<ComputerPlayer::RankedMove> HumanPlayer::get_hints(const Board& board, const Dictionary& dictionary) const {
+    if (hinter == nullptr || hint_count == 0) {
+        return vector<ComputerPlayer::RankedMove>();
+    }
+    auto start = chrono::steady_clock::now();
+    hinter->remove_tiles(hinter->get_tiles());
+    hinter->add_tiles(get_tiles());
+    vector<ComputerPlayer::RankedMove> hints = hinter->get_top_moves(board, dictionary, hint_count);
+    hint_latency.record(chrono::steady_clock::now() - start);
+    return hints;
+}
+
+const LatencyHistogram& HumanPlayer::get_hint_latency() const { return hint_latency; }
@@ -1,9 +1,13 @@
 #ifndef HUMAN_PLAYER_H
 #define HUMAN_PLAYER_H
 
+#include "computer_player.h"
+#include "latency_histogram.h"
 #include "move.h"
 #include "player.h"
+#include <chrono>
 #include <fstream>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -15,7 +19,27 @@ class HumanPlayer : public Player {
 
     bool is_human() const { return true; }
 
+    /*
+    Lets the player type HINT to see the count best moves for their rack, found by engine with the bounded search of
+    ComputerPlayer::get_top_moves in at most time, so the prompt never waits long. engine brings its own settings,
+    such as the move generator and the leave table, and its rack is replaced with this player's for every hint.
+    nullptr turns hints off.
+    */
+    void set_hints(std::shared_ptr<ComputerPlayer> engine, size_t count, std::chrono::milliseconds time);
+
+    /*
+    Returns the moves HINT shows, best first, and records how long finding them took in get_hint_latency
+    */
+    std::vector<ComputerPlayer::RankedMove> get_hints(const Board& board, const Dictionary& dictionary) const;
+
+    const LatencyHistogram& get_hint_latency() const;
+
   private:
+    std::shared_ptr<ComputerPlayer> hinter;
+    size_t hint_count = 0;
+    mutable LatencyHistogram hint_latency;
+
+
     std::vector<TileKind> parse_tiles(std::string& letters) const;
     void print_hand(std::ostream& out) const;
 };
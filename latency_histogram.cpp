@@ -0,0 +1,48 @@
+#include "latency_histogram.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+
+size_t LatencyHistogram::bucket_of(uint64_t micros) {
+    if (micros < SUB_BUCKETS) {
+        return micros;
+    }
+    // the top bit picks the power of two, the three bits below it the part of it
+    size_t top = 63 - __builtin_clzll(micros);
+    size_t part = (micros >> (top - 3)) & (SUB_BUCKETS - 1);
+    return (top - 2) * SUB_BUCKETS + part;
+}
+
+uint64_t LatencyHistogram::bucket_end(size_t bucket) {
+    if (bucket < SUB_BUCKETS) {
+        return bucket;
+    }
+    size_t top = bucket / SUB_BUCKETS + 2;
+    uint64_t part = bucket % SUB_BUCKETS;
+    uint64_t start = (SUB_BUCKETS + part) << (top - 3);
+    return start + (uint64_t(1) << (top - 3)) - 1;
+}
+
+void LatencyHistogram::record(chrono::nanoseconds latency) {
+    uint64_t micros = std::max<int64_t>(chrono::duration_cast<chrono::microseconds>(latency).count(), 0);
+    counts[bucket_of(micros)]++;
+    total++;
+    longest = std::max(longest, micros);
+}
+
+chrono::microseconds LatencyHistogram::percentile(double share) const {
+    if (total == 0) {
+        return chrono::microseconds(0);
+    }
+    size_t rank = std::max<size_t>(static_cast<size_t>(ceil(share * total)), 1);
+    size_t seen = 0;
+    for (size_t bucket = 0; bucket < BUCKETS; bucket++) {
+        seen += counts[bucket];
+        if (seen >= rank) {
+            return chrono::microseconds(std::min(bucket_end(bucket), longest));
+        }
+    }
+    return chrono::microseconds(longest);
+}
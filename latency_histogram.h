@@ -0,0 +1,44 @@
+#ifndef LATENCY_HISTOGRAM_H
+#define LATENCY_HISTOGRAM_H
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+/*
+Counts how long something took, to tell what share of the calls were slow.
+
+Latencies are kept in microseconds, in buckets that split every power of two into SUB_BUCKETS equal parts, so a
+percentile is never off by more than an eighth of its value, and recording one is a few shifts and an increment.
+Anything from a microsecond to hours fits.
+*/
+class LatencyHistogram {
+  public:
+    void record(std::chrono::nanoseconds latency);
+
+    size_t count() const { return total; }
+
+    /*
+    Returns the latency that share (0 to 1) of the recorded latencies are at most, rounded up to the end of its
+    bucket; zero if nothing was recorded
+    */
+    std::chrono::microseconds percentile(double share) const;
+
+    std::chrono::microseconds max() const { return std::chrono::microseconds(longest); }
+
+  private:
+    static const size_t SUB_BUCKETS = 8;
+    static const size_t BUCKETS = 64 * SUB_BUCKETS;
+
+    /*
+    Returns the bucket of a latency in microseconds, and the largest latency that bucket holds
+    */
+    static size_t bucket_of(uint64_t micros);
+    static uint64_t bucket_end(size_t bucket);
+
+    size_t counts[BUCKETS] = {};
+    size_t total = 0;
+    uint64_t longest = 0;
+};
+
+#endif
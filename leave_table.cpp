@@ -0,0 +1,147 @@
+#include "leave_table.h"
+
+#include "exceptions.h"
+#include "zobrist.h"
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <utility>
+
+using namespace std;
+
+LeaveTable LeaveTable::read(const string& file_path) {
+    ifstream file(file_path);
+    if (!file) {
+        throw FileException("cannot open leave table file!");
+    }
+
+    vector<pair<Key, float>> read_entries;
+    string line;
+    while (getline(file, line)) {
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+        istringstream fields(line);
+        string letters;
+        double value;
+        if (!(fields >> letters >> value)) {
+            throw FileException("bad line in leave table file: " + line);
+        }
+        // a lone dash is the empty leave
+        if (letters == "-") {
+            letters.clear();
+        }
+        Key key = pack(letters);
+        if (key == 0) {
+            throw FileException("bad leave in leave table file: " + letters);
+        }
+        read_entries.push_back(make_pair(key, static_cast<float>(value)));
+    }
+
+    // at most half full, so probe sequences stay short
+    LeaveTable table;
+    size_t capacity = 16;
+    while (capacity < read_entries.size() * 2) {
+        capacity *= 2;
+    }
+    table.slots.resize(capacity);
+    for (size_t i = 0; i < read_entries.size(); i++) {
+        Slot& slot = table.slots[table.slot_index(read_entries[i].first)];
+        if (slot.key == 0) {
+            table.entries++;
+        }
+        slot.key = read_entries[i].first;
+        slot.value = read_entries[i].second;
+    }
+
+    // single tiles are the fallback for leaves the table does not list
+    for (size_t i = 0; i < TILE_KINDS; i++) {
+        size_t counts[TILE_KINDS] = {};
+        counts[i] = 1;
+        table.tile_values[i] = table.slots[table.slot_index(pack(counts))].value;
+    }
+
+    // the slots are summed up, so the order the lines come in does not matter
+    table.fingerprint = zobrist_key(table.entries);
+    for (const Slot& slot : table.slots) {
+        if (slot.key != 0) {
+            uint32_t bits;
+            memcpy(&bits, &slot.value, sizeof(bits));
+            table.fingerprint += zobrist_key(zobrist_key(slot.key) ^ bits);
+        }
+    }
+    return table;
+}
+
+int LeaveTable::tile_index(char letter) {
+    if (letter == '?') {
+        return 26;
+    }
+    if (letter < 'a' || letter > 'z') {
+        return -1;
+    }
+    return letter - 'a';
+}
+
+LeaveTable::Key LeaveTable::pack(const size_t* counts) {
+    Key key = 1;
+    size_t tiles = 0;
+    for (size_t i = 0; i < TILE_KINDS; i++) {
+        tiles += counts[i];
+        if (tiles > MAX_TILES) {
+            return 0;
+        }
+        for (size_t j = 0; j < counts[i]; j++) {
+            key = (key << 5) | (i + 1);
+        }
+    }
+    return key;
+}
+
+LeaveTable::Key LeaveTable::pack(const string& letters) {
+    size_t counts[TILE_KINDS] = {};
+    for (size_t i = 0; i < letters.size(); i++) {
+        int index = tile_index(letters[i]);
+        if (index < 0) {
+            return 0;
+        }
+        counts[index]++;
+    }
+    return pack(counts);
+}
+
+double LeaveTable::value(const size_t* counts) const {
+    Key key = pack(counts);
+    if (key != 0 && !slots.empty()) {
+        const Slot& slot = slots[slot_index(key)];
+        if (slot.key == key) {
+            return slot.value;
+        }
+    }
+    double total = 0;
+    for (size_t i = 0; i < TILE_KINDS; i++) {
+        total += counts[i] * tile_values[i];
+    }
+    return total;
+}
+
+double LeaveTable::value(const string& letters) const {
+    size_t counts[TILE_KINDS] = {};
+    for (size_t i = 0; i < letters.size(); i++) {
+        int index = tile_index(letters[i]);
+        if (index >= 0) {
+            counts[index]++;
+        }
+    }
+    return value(counts);
+}
+
+size_t LeaveTable::slot_index(Key key) const {
+    size_t mask = slots.size() - 1;
+    // Fibonacci hashing spreads the packed keys, which differ mostly in their low bits
+    size_t index = ((key * 0x9E3779B97F4A7C15ull) >> 32) & mask;
+    while (slots[index].key != 0 && slots[index].key != key) {
+        index = (index + 1) & mask;
+    }
+    return index;
+}
@@ -0,0 +1,85 @@
+#ifndef LEAVE_TABLE_H
+#define LEAVE_TABLE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/*
+The value of the tiles a move leaves on the rack, in points.
+
+A leave is packed into a Key by sorting its tiles and storing each in 5 bits, below a leading 1 bit so that the empty
+leave still has a key of its own. The entries live in one flat open-addressing hash table, so a lookup is a hash and
+usually a single probe.
+
+Leaves that are not in the table are worth the sum of the values of their single tiles, so a table of single tiles
+already gives every leave a value, and longer entries only need to say how much better or worse a combination is.
+*/
+class LeaveTable {
+  public:
+    typedef uint64_t Key;
+
+    // The longest leave a Key can hold
+    static const size_t MAX_TILES = 12;
+
+    // Letters 'a' to 'z' are tiles 0 to 25 and the blank is tile 26
+    static const size_t TILE_KINDS = 27;
+
+    /*
+    Reads a table with one leave per line: the tiles, lowercase letters and '?' for the blank, then the value.
+    Empty lines and lines starting with '#' are skipped.
+    */
+    static LeaveTable read(const std::string& file_path);
+
+    /*
+    Returns the tile index of a letter, or -1 if no tile can stand for it
+    */
+    static int tile_index(char letter);
+
+    /*
+    Packs a leave given as a count per tile index. Leaves longer than MAX_TILES have no key and pack to 0.
+    */
+    static Key pack(const size_t* counts);
+
+    /*
+    Packs a leave given as letters, in any order
+    */
+    static Key pack(const std::string& letters);
+
+    /*
+    Returns the value of a leave given as a count per tile index (TILE_KINDS entries)
+    */
+    double value(const size_t* counts) const;
+
+    /*
+    Returns the value of a leave given as letters
+    */
+    double value(const std::string& letters) const;
+
+    size_t size() const { return entries; }
+
+    /*
+    Returns a hash of every leave in the table and its value: two tables with the same entries have the same
+    fingerprint, whichever process read them
+    */
+    uint64_t get_fingerprint() const { return fingerprint; }
+
+  private:
+    struct Slot {
+        Key key = 0;
+        float value = 0;
+    };
+
+    std::vector<Slot> slots;
+    size_t entries = 0;
+    float tile_values[TILE_KINDS] = {};
+    uint64_t fingerprint = 0;
+
+    /*
+    Returns the index of the slot holding key, or of the empty slot where it would go
+    */
+    size_t slot_index(Key key) const;
+};
+
+#endif
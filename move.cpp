@@ -1,5 +1,53 @@
 #include "move.h"
 
+#include <cassert>
+#include <utility>
+
 Direction operator!(Direction direction) {
     return direction == Direction::ACROSS ? Direction::DOWN : Direction::ACROSS;
 }
+
+CompactMove::CompactMove(const Move& move)
+        : kind(move.kind), direction(move.direction), row(move.row), column(move.column) {
+    assert(fits(move));
+    for (const TileKind& tile : move.tiles) {
+        push_back(tile);
+    }
+}
+
+bool CompactMove::fits(const Move& move) {
+    if (move.tiles.size() > MAX_TILES || move.row > UINT8_MAX || move.column > UINT8_MAX) {
+        return false;
+    }
+    for (const TileKind& tile : move.tiles) {
+        if (tile.points > UINT8_MAX) {
+            return false;
+        }
+    }
+    return true;
+}
+
+Move CompactMove::to_move() const {
+    std::vector<TileKind> tiles;
+    tiles.reserve(size);
+    for (size_t i = 0; i < size; i++) {
+        tiles.push_back(tile(i));
+    }
+    Move move(std::move(tiles));
+    move.kind = kind;
+    move.row = row;
+    move.column = column;
+    move.direction = direction;
+    return move;
+}
+
+void CompactMove::push_back(const TileKind& tile) {
+    assert(!full() && tile.points <= UINT8_MAX);
+    bool blank = tile.letter == TileKind::BLANK_LETTER;
+    letters[size] = blank ? tile.assigned : tile.letter;
+    points[size] = tile.points;
+    if (blank) {
+        blanks |= 1u << size;
+    }
+    size++;
+}
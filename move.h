@@ -2,10 +2,12 @@
 #define MOVE_H
 
 #include "tile_kind.h"
+#include <cstdint>
 #include <stdlib.h>
+#include <type_traits>
 #include <vector>
 
-enum class Direction {
+enum class Direction : uint8_t {
     ACROSS,
     DOWN,
     NONE,
@@ -13,7 +15,7 @@ enum class Direction {
 
 Direction operator!(Direction direction);
 
-enum class MoveKind {
+enum class MoveKind : uint8_t {
     PLACE,
     PASS,
     EXCHANGE,
@@ -26,10 +28,60 @@ struct Move {
     size_t column;
     Direction direction;
 
-    Move() : kind(MoveKind::PASS) {}
-    Move(std::vector<TileKind> tiles) : kind(MoveKind::EXCHANGE), tiles(tiles) {}
+    Move() : kind(MoveKind::PASS), row(0), column(0), direction(Direction::NONE) {}
+    Move(std::vector<TileKind> tiles)
+            : kind(MoveKind::EXCHANGE), tiles(tiles), row(0), column(0), direction(Direction::NONE) {}
     Move(std::vector<TileKind> tiles, size_t row, size_t column, Direction direction)
             : kind(MoveKind::PLACE), tiles(tiles), row(row), column(column), direction(direction) {}
 };
 
+/*
+A Move packed into 22 bytes that copy without allocating, for the move generators and for whatever stores many moves.
+
+letters holds the letter of every tile, or for a blank the letter it stands for, and bit i of blanks marks tile i as a
+blank. A move fits if it has at most MAX_TILES tiles, its square is within 256 rows and columns and no tile is worth
+more than 255 points; a Move that fits converts to a CompactMove and back without losing anything, other than a letter
+assigned to a tile that is not a blank. Only a Move that fits may be converted, which is checked with assert: callers
+check fits first and keep any other move as a Move.
+*/
+struct CompactMove {
+    static const size_t MAX_TILES = 8;
+
+    MoveKind kind = MoveKind::PASS;
+    Direction direction = Direction::NONE;
+    uint8_t row = 0;
+    uint8_t column = 0;
+    uint8_t size = 0;
+    uint8_t blanks = 0;
+    char letters[MAX_TILES] = {};
+    uint8_t points[MAX_TILES] = {};
+
+    CompactMove() = default;
+    explicit CompactMove(const Move& move);
+
+    static bool fits(const Move& move);
+
+    Move to_move() const;
+
+    TileKind tile(size_t i) const {
+        return blanks & (1u << i) ? TileKind(TileKind::BLANK_LETTER, points[i], letters[i])
+                                  : TileKind(letters[i], points[i]);
+    }
+
+    bool is_blank(size_t i) const { return blanks & (1u << i); }
+
+    bool full() const { return size == MAX_TILES; }
+
+    // Adds a tile after the last one; the move must not be full
+    void push_back(const TileKind& tile);
+
+    void pop_back() {
+        size--;
+        blanks &= ~(1u << size);
+    }
+};
+
+static_assert(std::is_trivially_copyable<CompactMove>::value, "CompactMove has to copy without allocating");
+static_assert(sizeof(CompactMove) == 22, "CompactMove is packed into 22 bytes");
+
 #endif
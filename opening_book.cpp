@@ -0,0 +1,148 @@
+#include "opening_book.h"
+
+#include "exceptions.h"
+#include "zobrist.h"
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+
+using namespace std;
+
+OpeningBook::OpeningBook(const Board& board, size_t keep) : board_fingerprint(fingerprint(board)), keep(keep) {}
+
+OpeningBook OpeningBook::read(const string& file_path) {
+    ifstream file(file_path);
+    if (!file) {
+        throw FileException("cannot open opening book file!");
+    }
+
+    string line;
+    string label;
+    uint64_t board_fingerprint;
+    size_t keep;
+    if (!getline(file, line) || !(istringstream(line) >> label >> hex >> board_fingerprint >> dec >> keep)
+        || label != "board") {
+        throw FileException("bad header in opening book file: " + line);
+    }
+    OpeningBook book(board_fingerprint, keep);
+
+    while (getline(file, line)) {
+        if (line.empty()) {
+            continue;
+        }
+        istringstream fields(line);
+        string key;
+        fields >> key;
+        vector<Entry> moves;
+        char direction;
+        Entry entry;
+        while (fields >> direction >> entry.row >> entry.column >> entry.tiles) {
+            if ((direction != '-' && direction != '|') || entry.row == 0 || entry.column == 0) {
+                throw FileException("bad move in opening book file: " + line);
+            }
+            entry.direction = direction == '|' ? Direction::DOWN : Direction::ACROSS;
+            entry.row--;
+            entry.column--;
+            moves.push_back(entry);
+        }
+        if (!fields.eof()) {
+            throw FileException("bad line in opening book file: " + line);
+        }
+        book.entries[key] = moves;
+    }
+    return book;
+}
+
+void OpeningBook::write(const string& file_path) const {
+    ofstream file(file_path);
+    if (!file) {
+        throw FileException("cannot write opening book file!");
+    }
+
+    // sorted, so that the same book is always the same file
+    vector<string> keys;
+    for (auto it = entries.begin(); it != entries.end(); it++) {
+        keys.push_back(it->first);
+    }
+    sort(keys.begin(), keys.end());
+
+    file << "board " << hex << board_fingerprint << dec << ' ' << keep << '\n';
+    for (const string& key : keys) {
+        file << key;
+        for (const Entry& entry : entries.at(key)) {
+            file << ' ' << (entry.direction == Direction::DOWN ? '|' : '-') << ' ' << entry.row + 1 << ' '
+                 << entry.column + 1 << ' ' << entry.tiles;
+        }
+        file << '\n';
+    }
+    if (!file) {
+        throw FileException("cannot write opening book file!");
+    }
+}
+
+string OpeningBook::rack_key(const vector<TileKind>& rack) {
+    string key;
+    for (const TileKind& tile : rack) {
+        key += tile.letter;
+    }
+    sort(key.begin(), key.end());
+    return key;
+}
+
+uint64_t OpeningBook::fingerprint(const Board& board) {
+    uint64_t hash = 0;
+    auto mix = [&hash](uint64_t value) { hash = zobrist_key(hash ^ value); };
+    mix(board.rows);
+    mix(board.columns);
+    mix(board.start.row);
+    mix(board.start.column);
+    for (size_t row = 0; row < board.rows; row++) {
+        for (size_t column = 0; column < board.columns; column++) {
+            const BoardSquare& square = board.square_at(Board::Position(row, column));
+            mix(square.letter_multiplier);
+            mix(square.word_multiplier);
+        }
+    }
+    return hash;
+}
+
+void OpeningBook::add(const vector<TileKind>& rack, const vector<Move>& moves) {
+    vector<Entry>& entry = entries[rack_key(rack)];
+    entry.clear();
+    for (size_t i = 0; i < moves.size() && i < keep; i++) {
+        string tiles;
+        for (const TileKind& tile : moves[i].tiles) {
+            tiles += tile.letter;
+            if (tile.letter == TileKind::BLANK_LETTER) {
+                tiles += tile.assigned;
+            }
+        }
+        entry.push_back(Entry{moves[i].row, moves[i].column, moves[i].direction, tiles});
+    }
+}
+
+vector<Move> OpeningBook::find(const Board& board, const vector<TileKind>& rack) const {
+    vector<Move> moves;
+    auto found = entries.find(rack_key(rack));
+    if (found == entries.end() || board.in_bounds_and_has_tile(board.start) || fingerprint(board) != board_fingerprint) {
+        return moves;
+    }
+
+    for (const Entry& entry : found->second) {
+        vector<TileKind> tiles;
+        for (size_t i = 0; i < entry.tiles.size(); i++) {
+            auto tile = find_if(rack.begin(), rack.end(), [&](const TileKind& t) { return t.letter == entry.tiles[i]; });
+            if (tile == rack.end()) {
+                return vector<Move>();
+            }
+            tiles.push_back(*tile);
+            if (tile->letter == TileKind::BLANK_LETTER && i + 1 < entry.tiles.size()) {
+                tiles.back().assigned = entry.tiles[++i];
+            }
+        }
+        moves.push_back(Move(tiles, entry.row, entry.column, entry.direction));
+    }
+    return moves;
+}
+
+bool OpeningBook::contains(const vector<TileKind>& rack) const { return entries.count(rack_key(rack)) > 0; }
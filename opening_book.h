@@ -0,0 +1,83 @@
+#ifndef OPENING_BOOK_H
+#define OPENING_BOOK_H
+
+#include "board.h"
+#include "move.h"
+#include "tile_kind.h"
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/*
+The best first moves for every rack it holds, for one board layout.
+
+On an empty board the moves only depend on the rack, the layout of the board and its start square, so they can be
+found once, offline (see fill_opening_book.cpp), and looked up in every game after. A rack's key is its letters,
+sorted, with '?' for a blank. Each rack keeps its `keep` best moves by equity, best first, or all of them if it has
+fewer.
+
+The moves are only the best for the dictionary, tile values and leave table the book was filled with, so a game
+should use a book filled with its own configuration. The layout is checked: a book answers for no other board.
+
+The file starts with a line "board <fingerprint> <keep>", followed by one line per rack: the key, then every move
+the way a human player types a PLACE, as its direction, row, column and tiles, with a blank written as '?' followed
+by the letter it stands for.
+*/
+class OpeningBook {
+  public:
+    OpeningBook(const Board& board, size_t keep);
+
+    static OpeningBook read(const std::string& file_path);
+
+    void write(const std::string& file_path) const;
+
+    /*
+    Returns the key of a rack, which is the same for two racks exactly when they hold the same letters
+    */
+    static std::string rack_key(const std::vector<TileKind>& rack);
+
+    /*
+    Returns a hash of the layout of a board: its size, start square and multipliers, but not its tiles
+    */
+    static uint64_t fingerprint(const Board& board);
+
+    /*
+    Sets the moves of a rack, best first. Only the first keep of them are kept.
+    */
+    void add(const std::vector<TileKind>& rack, const std::vector<Move>& moves);
+
+    /*
+    Returns the first moves for rack on board, made of the rack's own tiles, best first. Returns nothing if board
+    is not empty, its layout is not the one the book was filled for, or the rack is not in the book.
+    */
+    std::vector<Move> find(const Board& board, const std::vector<TileKind>& rack) const;
+
+    /*
+    Returns whether the book holds the moves of rack
+    */
+    bool contains(const std::vector<TileKind>& rack) const;
+
+    size_t get_keep() const { return keep; }
+
+    uint64_t get_fingerprint() const { return board_fingerprint; }
+
+    size_t size() const { return entries.size(); }
+
+  private:
+    // A move with its tiles as letters, '?' followed by the letter it stands for for a blank
+    struct Entry {
+        size_t row;
+        size_t column;
+        Direction direction;
+        std::string tiles;
+    };
+
+    uint64_t board_fingerprint;
+    size_t keep;
+    std::unordered_map<std::string, std::vector<Entry>> entries;
+
+    OpeningBook(uint64_t board_fingerprint, size_t keep) : board_fingerprint(board_fingerprint), keep(keep) {}
+};
+
+#endif
@@ -29,6 +29,14 @@ void Player::add_tiles(const std::vector<TileKind>& tiles) {
     }
 }
 
+std::vector<TileKind> Player::get_tiles() const {
+    std::vector<TileKind> tiles;
+    for (auto it = this->collection.cbegin(); it != this->collection.cend(); ++it) {
+        tiles.push_back(*it);
+    }
+    return tiles;
+}
+
 bool Player::has_tile(TileKind tile) {
     if (this->collection.count_tiles(tile) == 0) {
         return false;
@@ -39,6 +39,9 @@ class Player {
     // Adds tiles to player's hand.
     void add_tiles(const std::vector<TileKind>& tiles);
 
+    // Returns a copy of every tile in the player's hand.
+    std::vector<TileKind> get_tiles() const;
+
     // Checks if player has a matching tile.
     bool has_tile(TileKind tile);
 
@@ -1,9 +1,11 @@
 #include "scrabble.h"
 
 #include "formatting.h"
+#include <chrono>
 #include <iomanip>
 #include <iostream>
 #include <map>
+#include <thread>
 
 using namespace std;
 
@@ -11,9 +13,42 @@ using namespace std;
 Scrabble::Scrabble(const ScrabbleConfig& config)
         : hand_size(config.hand_size),
           minimum_word_length(config.minimum_word_length),
+          move_time(config.move_time),
+          endgame_time(config.endgame_time),
+          ponder(config.ponder),
+          instrument(config.instrument),
+          hints(config.hints),
+          hint_time(config.hint_time),
+          seed(config.seed),
+          simulation_candidates(config.simulation_candidates),
+          simulation_plies(config.simulation_plies),
+          simulation_iterations(config.simulation_iterations),
+          fast_playouts(config.fast_playouts),
+          lookahead_candidates(config.lookahead_candidates),
+          lookahead_samples(config.lookahead_samples),
+          lookahead_time(config.lookahead_time),
           tile_bag(TileBag::read(config.tile_bag_file_path, config.seed)),
           board(Board::read(config.board_file_path)),
-          dictionary(Dictionary::read(config.dictionary_file_path)) {}
+          dictionary(Dictionary::read(config.dictionary_file_path)) {
+    if (config.engine == "gaddag") {
+        dictionary.build_gaddag();
+        engine = ComputerPlayer::Engine::GADDAG;
+    } else {
+        engine = ComputerPlayer::Engine::TRIE;
+    }
+    fast_effort.anchor_nodes = config.fast_anchor_nodes;
+    fast_effort.good_enough = config.fast_good_enough;
+    fast_effort.greedy = config.fast_greedy;
+    if (!config.leaves_file_path.empty()) {
+        leaves = make_shared<LeaveTable>(LeaveTable::read(config.leaves_file_path));
+    }
+    if (!config.opening_book_file_path.empty()) {
+        book = make_shared<OpeningBook>(OpeningBook::read(config.opening_book_file_path));
+    }
+    if (config.transposition_cache > 0) {
+        transpositions = make_shared<TranspositionCache>(config.transposition_cache);
+    }
+}
 
 // Game Loop should cycle through players and get and execute that players move
 // until the game is over.
@@ -24,6 +59,10 @@ void Scrabble::game_loop() {
     // keep looping till game is over
     for (size_t i = 0; true; i++) {
         board.print(cout);
+        shared_ptr<ComputerPlayer> computer = dynamic_pointer_cast<ComputerPlayer>(players[i]);
+        if (computer != nullptr) {
+            computer->set_unseen_tiles(unseen_tiles(i), tile_bag.count_tiles());
+        }
         // get_move will error check the user inputs
         Move move = players[i]->get_move(this->board, this->dictionary);
 
@@ -73,12 +112,31 @@ void Scrabble::game_loop() {
         if ((pass == this->num_human_players) && (i + 1 == players.size())) {
             return;
         }
+        // a computer thinks on while a human takes the next turn
+        if (computer != nullptr && ponder && players[(i + 1) % players.size()]->is_human()) {
+            computer->set_unseen_tiles(unseen_tiles(i), tile_bag.count_tiles());
+            computer->start_pondering(board, dictionary);
+        }
         if (i + 1 == players.size()) {
             i = -1;
         }
     }
 }
 
+vector<TileKind> Scrabble::unseen_tiles(size_t player) const {
+    vector<TileKind> unseen;
+    for (auto it = tile_bag.cbegin(); it != tile_bag.cend(); ++it) {
+        unseen.push_back(*it);
+    }
+    for (size_t i = 0; i < players.size(); i++) {
+        if (i != player) {
+            vector<TileKind> rack = players[i]->get_tiles();
+            unseen.insert(unseen.end(), rack.begin(), rack.end());
+        }
+    }
+    return unseen;
+}
+
 // Performs final score subtraction.
 void Scrabble::final_subtraction(vector<shared_ptr<Player>>& plrs) {
     size_t allHandSum = 0;
@@ -104,12 +162,43 @@ void Scrabble::add_players() {
     for (int i = 0; i < num; i++) {
         cout << "Enter name of player " << i + 1 << ": ";
         cin >> name;
-        cout << "Is this player a computer? (y/n): ";
+        cout << "Is this player a computer? (y/n, or f for a fast one): ";
         cin >> choice;
-        if (choice == 'y') {
-            players.push_back(make_shared<ComputerPlayer>(name, hand_size));
+        if (choice == 'y' || choice == 'f') {
+            shared_ptr<ComputerPlayer> computer = make_shared<ComputerPlayer>(name, hand_size);
+            computer->set_threads(thread::hardware_concurrency());
+            computer->set_engine(engine);
+            computer->set_budget(chrono::milliseconds(move_time), 0);
+            computer->set_leave_table(leaves);
+            computer->set_opening_book(book);
+            computer->set_transposition_cache(transpositions);
+            computer->set_simulation(simulation_candidates, simulation_plies, simulation_iterations, seed + i);
+            if (fast_playouts) {
+                computer->set_playout_effort(fast_effort);
+            }
+            if (choice == 'f') {
+                computer->set_effort(fast_effort);
+            }
+            computer->set_lookahead(
+                    lookahead_candidates, lookahead_samples, chrono::milliseconds(lookahead_time), seed + i);
+            // with more than one opponent the unseen tiles do not tell whose rack is whose
+            computer->set_endgame_time(chrono::milliseconds(num == 2 ? endgame_time : 0));
+            if (instrument) {
+                computer->set_instrumentation(true, &clog);
+            }
+            players.push_back(computer);
         } else if (choice == 'n') {
-            players.push_back(make_shared<HumanPlayer>(name, hand_size));
+            shared_ptr<HumanPlayer> human = make_shared<HumanPlayer>(name, hand_size);
+            if (hints > 0) {
+                shared_ptr<ComputerPlayer> hinter = make_shared<ComputerPlayer>(name, hand_size);
+                hinter->set_threads(thread::hardware_concurrency());
+                hinter->set_engine(engine);
+                hinter->set_leave_table(leaves);
+                hinter->set_opening_book(book);
+                hinter->set_transposition_cache(transpositions);
+                human->set_hints(hinter, hints, chrono::milliseconds(hint_time));
+            }
+            players.push_back(human);
             this->num_human_players++;
         }
         players[i]->add_tiles(tile_bag.remove_random_tiles(hand_size));
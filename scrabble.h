@@ -30,12 +30,33 @@ class Scrabble {
     size_t hand_size;
     size_t minimum_word_length;
     size_t num_human_players = 0;
+    ComputerPlayer::Engine engine;
+    size_t move_time;
+    size_t endgame_time;
+    bool ponder;
+    bool instrument;
+    size_t hints;
+    size_t hint_time;
+    std::shared_ptr<const LeaveTable> leaves;
+    std::shared_ptr<const OpeningBook> book;
+    std::shared_ptr<TranspositionCache> transpositions;
+    uint32_t seed;
+    size_t simulation_candidates;
+    size_t simulation_plies;
+    size_t simulation_iterations;
+    bool fast_playouts;
+    ComputerPlayer::Effort fast_effort;
+    size_t lookahead_candidates;
+    size_t lookahead_samples;
+    size_t lookahead_time;
     TileBag tile_bag;
     Board board;
     Dictionary dictionary;
     std::vector<std::shared_ptr<Player>> players;
 
     void add_players();
+    // The tiles player cannot see: the bag and everybody else's rack
+    std::vector<TileKind> unseen_tiles(size_t player) const;
     void game_loop();
     void print_result();
 };
@@ -65,6 +65,46 @@ ScrabbleConfig ScrabbleConfig::read(string file_path) {
                     config.tile_bag_file_path = value_buffer;
                 } else if (key_buffer == "DICTIONARY") {
                     config.dictionary_file_path = value_buffer;
+                } else if (key_buffer == "ENGINE") {
+                    config.engine = value_buffer;
+                } else if (key_buffer == "LEAVES") {
+                    config.leaves_file_path = value_buffer;
+                } else if (key_buffer == "SIMULATION_CANDIDATES") {
+                    config.simulation_candidates = stoul(value_buffer);
+                } else if (key_buffer == "SIMULATION_PLIES") {
+                    config.simulation_plies = stoul(value_buffer);
+                } else if (key_buffer == "SIMULATION_ITERATIONS") {
+                    config.simulation_iterations = stoul(value_buffer);
+                } else if (key_buffer == "LOOKAHEAD_CANDIDATES") {
+                    config.lookahead_candidates = stoul(value_buffer);
+                } else if (key_buffer == "LOOKAHEAD_SAMPLES") {
+                    config.lookahead_samples = stoul(value_buffer);
+                } else if (key_buffer == "LOOKAHEAD_TIME") {
+                    config.lookahead_time = stoul(value_buffer);
+                } else if (key_buffer == "MOVE_TIME") {
+                    config.move_time = stoul(value_buffer);
+                } else if (key_buffer == "ENDGAME_TIME") {
+                    config.endgame_time = stoul(value_buffer);
+                } else if (key_buffer == "OPENING_BOOK") {
+                    config.opening_book_file_path = value_buffer;
+                } else if (key_buffer == "TRANSPOSITION_CACHE") {
+                    config.transposition_cache = stoul(value_buffer);
+                } else if (key_buffer == "PONDER") {
+                    config.ponder = value_buffer == "yes";
+                } else if (key_buffer == "FAST_PLAYOUTS") {
+                    config.fast_playouts = value_buffer == "yes";
+                } else if (key_buffer == "FAST_ANCHOR_NODES") {
+                    config.fast_anchor_nodes = stoul(value_buffer);
+                } else if (key_buffer == "FAST_GOOD_ENOUGH") {
+                    config.fast_good_enough = stoul(value_buffer);
+                } else if (key_buffer == "FAST_GREEDY") {
+                    config.fast_greedy = value_buffer == "yes";
+                } else if (key_buffer == "HINTS") {
+                    config.hints = stoul(value_buffer);
+                } else if (key_buffer == "HINT_TIME") {
+                    config.hint_time = stoul(value_buffer);
+                } else if (key_buffer == "INSTRUMENT") {
+                    config.instrument = value_buffer == "yes";
                 }
                 state = ParserState::LOOKING_FOR_KEY;
             } else {
@@ -12,6 +12,43 @@ class ScrabbleConfig {
     std::string board_file_path;
     std::string tile_bag_file_path;
     std::string dictionary_file_path;
+    // Move generator for computer players: "trie" (the default) or "gaddag"
+    std::string engine = "trie";
+    // Leave table for computer players to rank moves by equity (see LeaveTable); empty ranks by points
+    std::string leaves_file_path;
+    // Computer players simulate this many candidate moves before picking one; 0 picks the best move right away
+    size_t simulation_candidates = 0;
+    size_t simulation_plies = 2;
+    size_t simulation_iterations = 100;
+    // Whether simulations play their games out with fast players (see below) instead of full searches; "yes" does
+    bool fast_playouts = false;
+    // Computer players weigh this many candidate moves against the best replies of sampled opponent racks before
+    // picking one; 0 turns this off, and simulation goes first. The time caps each move, in milliseconds.
+    size_t lookahead_candidates = 0;
+    size_t lookahead_samples = 16;
+    size_t lookahead_time = 1000;
+    // Longest a computer player may think about a move, in milliseconds; 0 searches every move
+    size_t move_time = 0;
+    // Longest a computer player may spend solving the endgame of a two player game, in milliseconds; 0 turns it off
+    size_t endgame_time = 5000;
+    // Opening book for computer players to look their first move up in (see OpeningBook); empty searches for it
+    std::string opening_book_file_path;
+    // Slots in the transposition cache computer players share (see TranspositionCache); 0 gives them none
+    size_t transposition_cache = 0;
+    // The effort of fast computer players, picked for each player when the game is set up (see
+    // ComputerPlayer::Effort): nodes per anchor, 0 for no cap; points good enough to stop at, 0 for none; and whether
+    // they play the best move of the first anchor that has one ("yes")
+    size_t fast_anchor_nodes = 64;
+    size_t fast_good_enough = 0;
+    bool fast_greedy = false;
+    // How many moves the HINT command shows human players, and the longest it may search for them, in milliseconds;
+    // 0 hints turns the command off
+    size_t hints = 3;
+    size_t hint_time = 50;
+    // Whether computer players think ahead while a human player takes their turn; "yes" turns it on
+    bool ponder = false;
+    // Whether computer players log what every move's search did to standard error, timings included; "yes" turns it on
+    bool instrument = false;
 
     static ScrabbleConfig read(std::string file_path);
 };
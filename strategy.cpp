@@ -0,0 +1,52 @@
+#include "strategy.h"
+#include <chrono>
+
+using namespace std;
+
+SearchStrategy::SearchStrategy(const string& name) : name(name) {}
+
+string SearchStrategy::get_name() const { return name; }
+
+Move SearchStrategy::choose_move(const ComputerPlayer& player, const Board& board, const Dictionary& dictionary) const {
+    ComputerPlayer& chooser = player.get_chooser([this](ComputerPlayer& chooser) {
+        // the strategy alone decides what the moves are ranked by
+        chooser.set_leave_table(nullptr);
+        chooser.set_effort(ComputerPlayer::Effort());
+        chooser.set_simulation(0, 2, 0);
+        chooser.set_lookahead(0, 0, chrono::milliseconds(0));
+        configure(chooser);
+    });
+    return chooser.get_move(board, dictionary);
+}
+
+GreedyStrategy::GreedyStrategy() : SearchStrategy("greedy") {}
+
+void GreedyStrategy::configure(ComputerPlayer&) const {}
+
+EquityStrategy::EquityStrategy(shared_ptr<const LeaveTable> leaves) : EquityStrategy("equity", leaves) {}
+
+EquityStrategy::EquityStrategy(const string& name, shared_ptr<const LeaveTable> leaves)
+        : SearchStrategy(name), leaves(leaves) {}
+
+void EquityStrategy::configure(ComputerPlayer& chooser) const { chooser.set_leave_table(leaves); }
+
+CappedStrategy::CappedStrategy(const ComputerPlayer::Effort& effort, shared_ptr<const LeaveTable> leaves)
+        : EquityStrategy("capped", leaves), effort(effort) {}
+
+void CappedStrategy::configure(ComputerPlayer& chooser) const {
+    EquityStrategy::configure(chooser);
+    chooser.set_effort(effort);
+}
+
+SimulationStrategy::SimulationStrategy(
+        shared_ptr<const LeaveTable> leaves, size_t candidates, size_t plies, size_t iterations, uint32_t seed)
+        : EquityStrategy("simulation", leaves),
+          candidates(candidates),
+          plies(plies),
+          iterations(iterations),
+          seed(seed) {}
+
+void SimulationStrategy::configure(ComputerPlayer& chooser) const {
+    EquityStrategy::configure(chooser);
+    chooser.set_simulation(candidates, plies, iterations, seed);
+}
@@ -0,0 +1,117 @@
+#ifndef STRATEGY_H
+#define STRATEGY_H
+
+#include "board.h"
+#include "computer_player.h"
+#include "dictionary.h"
+#include "leave_table.h"
+#include "move.h"
+#include <cstdint>
+#include <memory>
+#include <string>
+
+/*
+How a ComputerPlayer picks its move, swappable at runtime with ComputerPlayer::set_strategy, so that two ways of
+playing can be measured against each other (see head_to_head.cpp) without building two kinds of player.
+*/
+class Strategy {
+  public:
+    virtual ~Strategy() {}
+
+    virtual std::string get_name() const = 0;
+
+    /*
+    Returns the move player makes on board: a placement, an exchange or a pass. The player's rack, unseen tiles and
+    engine are what the move is picked for; how it is picked is up to the strategy.
+    */
+    virtual Move choose_move(const ComputerPlayer& player, const Board& board, const Dictionary& dictionary) const = 0;
+};
+
+/*
+A strategy that leaves the move to the player's chooser (see ComputerPlayer::get_chooser): a copy of the player with
+its engine, thread pool, budget, opening book, transposition cache, endgame time and timing settings, kept from move
+to move. The strategy replaces only how the chooser ranks moves: configure sets it up from no leave table, a full
+search, and no simulation or lookahead. Each player keeps a chooser of its own, so one strategy can serve any number
+of players at once.
+*/
+class SearchStrategy : public Strategy {
+  public:
+    explicit SearchStrategy(const std::string& name);
+
+    std::string get_name() const override;
+
+    Move choose_move(const ComputerPlayer& player, const Board& board, const Dictionary& dictionary) const override;
+
+  protected:
+    // Sets chooser up to play the way this strategy does
+    virtual void configure(ComputerPlayer& chooser) const = 0;
+
+  private:
+    std::string name;
+};
+
+/*
+Plays the highest scoring placement and never exchanges
+*/
+class GreedyStrategy : public SearchStrategy {
+  public:
+    GreedyStrategy();
+
+  protected:
+    void configure(ComputerPlayer& chooser) const override;
+};
+
+/*
+Plays the placement with the best points plus leave value, and exchanges when a leave is worth more (see
+ComputerPlayer::get_best_exchange)
+*/
+class EquityStrategy : public SearchStrategy {
+  public:
+    EquityStrategy(std::shared_ptr<const LeaveTable> leaves);
+
+  protected:
+    EquityStrategy(const std::string& name, std::shared_ptr<const LeaveTable> leaves);
+
+    void configure(ComputerPlayer& chooser) const override;
+
+  private:
+    std::shared_ptr<const LeaveTable> leaves;
+};
+
+/*
+Plays by equity, but only searches as hard as effort allows (see ComputerPlayer::Effort)
+*/
+class CappedStrategy : public EquityStrategy {
+  public:
+    CappedStrategy(const ComputerPlayer::Effort& effort, std::shared_ptr<const LeaveTable> leaves);
+
+  protected:
+    void configure(ComputerPlayer& chooser) const override;
+
+  private:
+    ComputerPlayer::Effort effort;
+};
+
+/*
+Plays the candidate by equity that does best when played out (see ComputerPlayer::set_simulation)
+*/
+class SimulationStrategy : public EquityStrategy {
+  public:
+    SimulationStrategy(
+            std::shared_ptr<const LeaveTable> leaves,
+            size_t candidates,
+            size_t plies,
+            size_t iterations,
+            uint32_t seed = 0);
+
+  protected:
+    void configure(ComputerPlayer& chooser) const override;
+
+  private:
+    size_t candidates;
+    size_t plies;
+    size_t iterations;
+    uint32_t seed;
+};
+
+#endif
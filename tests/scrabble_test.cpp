@@ -2,6 +2,10 @@
 #include <iostream>
 #include <string>
 #include <algorithm>
+#include <set>
+#include <chrono>
+#include <cstring>
+#include <sstream>
 
 #include "scrabble_config.h"
 #include "board.h"
@@ -9,6 +13,15 @@
 #include "tile_kind.h"
 #include "human_player.h"
 #include "computer_player.h"
+#include "tile_bag.h"
+#include "leave_table.h"
+#include "endgame_solver.h"
+#include "opening_book.h"
+#include "transposition_cache.h"
+#include "latency_histogram.h"
+#include "batch_scorer.h"
+#include "strategy.h"
+#include <thread>
 
 #define DICT_PATH "config/english-dictionary.txt"
 
@@ -1037,3 +1050,1338 @@ TEST_F(ComputerPlayerTest, stress_test) {
 	test_pts(res, 57);
 }
 
+
+bool same_move(const Move& a, const Move& b) {
+	if (a.kind != b.kind || a.tiles.size() != b.tiles.size())
+		return false;
+	if (a.kind == MoveKind::PLACE && (a.row != b.row || a.column != b.column || a.direction != b.direction))
+		return false;
+	for (size_t i = 0; i < a.tiles.size(); i++) {
+		if (a.tiles[i].letter != b.tiles[i].letter || a.tiles[i].assigned != b.tiles[i].assigned)
+			return false;
+	}
+	return true;
+}
+
+TEST_F(ComputerPlayerTest, parallel_matches_sequential) {
+	Board b = Board::read("config/standard-board.txt");	
+	Dictionary d = Dictionary::read(DICT_PATH);
+	ComputerPlayer cpu("cpu", 7);
+
+	place_two_words(b);
+
+	vector<TileKind> t0;
+    t0.push_back(TileKind('A', 3));
+    t0.push_back(TileKind('B', 1));
+	t0.push_back(TileKind('F', 2));
+	t0.push_back(TileKind('T', 1));
+	t0.push_back(TileKind('N', 3));
+	t0.push_back(TileKind('O', 7));
+	t0.push_back(TileKind('?', 1));
+
+	cpu.add_tiles(t0);
+
+	Move sequential = cpu.get_move(b, d);
+	for (size_t threads = 2; threads <= 8; threads *= 2) {
+		cpu.set_threads(threads);
+		EXPECT_EQ(cpu.get_threads(), threads);
+		Move parallel = cpu.get_move(b, d);
+		EXPECT_TRUE(same_move(sequential, parallel));
+	}
+	// 6 10 | hit oaten
+	test_pts(b.test_place(sequential), 38);
+}
+
+// Every valid move as a string, so two engines' moves can be compared as sets
+set<string> move_set(const vector<Move>& moves) {
+	set<string> keys;
+	for (const Move& m : moves) {
+		string key = to_string(m.row) + ' ' + to_string(m.column) + (m.direction == Direction::ACROSS ? " - " : " | ");
+		for (const TileKind& t : m.tiles) {
+			key += t.letter;
+			if (t.letter == TileKind::BLANK_LETTER)
+				key += t.assigned;
+		}
+		keys.insert(key);
+	}
+	return keys;
+}
+
+// Plays a game with the GADDAG engine and checks that both engines find the same moves in every position
+void check_engines_agree(const string& board_path, const string& bag_path, uint32_t seed, size_t hand_size, size_t turns, Dictionary& d) {
+	Board b = Board::read(board_path);
+	TileBag bag = TileBag::read(bag_path, seed);
+	ComputerPlayer cpu("cpu", hand_size);
+	cpu.add_tiles(bag.remove_random_tiles(hand_size));
+
+	for (size_t turn = 0; turn < turns; turn++) {
+		cpu.set_engine(ComputerPlayer::Engine::TRIE);
+		set<string> trie = move_set(cpu.get_legal_moves(b, d));
+		cpu.set_engine(ComputerPlayer::Engine::GADDAG);
+		vector<Move> moves = cpu.get_legal_moves(b, d);
+		EXPECT_EQ(trie, move_set(moves));
+
+		Move m = cpu.get_move(b, d);
+		if (m.kind != MoveKind::PLACE || bag.count_tiles() < m.tiles.size())
+			break;
+		b.place(m);
+		cpu.remove_tiles(m.tiles);
+		cpu.add_tiles(bag.remove_random_tiles(m.tiles.size()));
+	}
+}
+
+TEST_F(ComputerPlayerTest, gaddag_matches_trie) {
+	Dictionary d = Dictionary::read(DICT_PATH);
+	d.build_gaddag();
+
+	for (uint32_t seed = 1; seed <= 4; seed++) {
+		check_engines_agree("config/small-board.txt", "config/small-tile-bag.txt", seed, 5, 6, d);
+	}
+	check_engines_agree("config/standard-board.txt", "config/english-tile-bag.txt", 54, 7, 6, d);
+}
+
+TEST_F(ComputerPlayerTest, gaddag_stress_test) {
+	Board b = Board::read("config/standard-board.txt");	
+	Dictionary d = Dictionary::read(DICT_PATH);
+	d.build_gaddag();
+	ComputerPlayer cpu("cpu", 10);
+	cpu.set_engine(ComputerPlayer::Engine::GADDAG);
+
+	place_concave_words(b);
+
+	vector<TileKind> t0;
+    t0.push_back(TileKind('A', 3));
+	t0.push_back(TileKind('?', 1));
+	t0.push_back(TileKind('T', 1));
+	t0.push_back(TileKind('M', 3));
+	t0.push_back(TileKind('?', 1));
+	t0.push_back(TileKind('S', 4));
+	t0.push_back(TileKind('Z', 7));
+	t0.push_back(TileKind('P', 2));
+	t0.push_back(TileKind('D', 3));
+	t0.push_back(TileKind('F', 4));
+
+	cpu.add_tiles(t0);
+
+	Move m = cpu.get_move(b, d);
+	PlaceResult res = b.test_place(m);
+	// 3 10 | ma el se flamines
+	test_pts(res, 57);
+}
+
+TEST_F(ComputerPlayerTest, top_moves) {
+	Board b = Board::read("config/standard-board.txt");	
+	Dictionary d = Dictionary::read(DICT_PATH);
+	d.build_gaddag();
+	ComputerPlayer cpu("cpu", 7);
+	cpu.set_engine(ComputerPlayer::Engine::GADDAG);
+
+	place_two_words(b);
+
+	vector<TileKind> t0;
+    t0.push_back(TileKind('A', 3));
+    t0.push_back(TileKind('B', 1));
+	t0.push_back(TileKind('F', 2));
+	t0.push_back(TileKind('T', 1));
+	t0.push_back(TileKind('N', 3));
+	t0.push_back(TileKind('O', 7));
+	t0.push_back(TileKind('?', 1));
+
+	cpu.add_tiles(t0);
+
+	// the same scores as sorting every legal move
+	vector<unsigned int> all;
+	for (const Move& m : cpu.get_legal_moves(b, d)) {
+		all.push_back(b.test_place(m).points);
+	}
+	sort(all.rbegin(), all.rend());
+
+	vector<ComputerPlayer::RankedMove> top = cpu.get_top_moves(b, d, 10);
+	ASSERT_EQ(top.size(), 10);
+	EXPECT_TRUE(same_move(top[0].move, cpu.get_move(b, d)));
+	for (size_t i = 0; i < top.size(); i++) {
+		PlaceResult res = b.test_place(top[i].move);
+		EXPECT_EQ(top[i].points, res.points);
+		EXPECT_EQ(top[i].words, res.words);
+		EXPECT_EQ(top[i].points, all[i]);
+	}
+
+	// ties are broken the same way with any number of threads
+	cpu.set_threads(4);
+	vector<ComputerPlayer::RankedMove> parallel = cpu.get_top_moves(b, d, 10);
+	ASSERT_EQ(parallel.size(), top.size());
+	for (size_t i = 0; i < top.size(); i++) {
+		EXPECT_TRUE(same_move(top[i].move, parallel[i].move));
+	}
+
+	// every legal move, once the moves blank pruning drops from the best ones are back
+	cpu.set_blank_pruning(false);
+	EXPECT_EQ(cpu.get_top_moves(b, d, all.size() + 5).size(), all.size());
+	EXPECT_TRUE(cpu.get_top_moves(b, d, 0).empty());
+}
+
+TEST_F(ComputerPlayerTest, budgeted_search) {
+	Board b = Board::read("config/standard-board.txt");	
+	Dictionary d = Dictionary::read(DICT_PATH);
+	ComputerPlayer cpu("cpu", 10);
+
+	place_concave_words(b);
+
+	vector<TileKind> t0;
+    t0.push_back(TileKind('A', 3));
+	t0.push_back(TileKind('?', 1));
+	t0.push_back(TileKind('T', 1));
+	t0.push_back(TileKind('M', 3));
+	t0.push_back(TileKind('?', 1));
+	t0.push_back(TileKind('S', 4));
+	t0.push_back(TileKind('Z', 7));
+	t0.push_back(TileKind('P', 2));
+	t0.push_back(TileKind('D', 3));
+	t0.push_back(TileKind('F', 4));
+
+	cpu.add_tiles(t0);
+
+	// stops on time with the best move found so far
+	cpu.set_budget(chrono::milliseconds(100), 0);
+	auto start = chrono::steady_clock::now();
+	Move m = cpu.get_move(b, d);
+	EXPECT_LT(chrono::steady_clock::now() - start, chrono::seconds(2));
+	EXPECT_FALSE(cpu.get_search_complete());
+	ASSERT_EQ(m.kind, MoveKind::PLACE);
+	EXPECT_TRUE(b.test_place(m).valid);
+
+	cpu.set_budget(chrono::milliseconds(0), 5000);
+	cpu.get_move(b, d);
+	EXPECT_FALSE(cpu.get_search_complete());
+	EXPECT_GE(cpu.get_nodes_visited(), 5000);
+	EXPECT_LT(cpu.get_nodes_visited(), 5000 + ComputerPlayer::BUDGET_CHECK_INTERVAL);
+
+	// a budget that is never reached gives the same move as no budget
+	Board b2 = Board::read("config/standard-board.txt");
+	place_two_words(b2);
+	ComputerPlayer cpu2("cpu", 7);
+	vector<TileKind> t1;
+    t1.push_back(TileKind('A', 3));
+    t1.push_back(TileKind('B', 1));
+	t1.push_back(TileKind('F', 2));
+	t1.push_back(TileKind('T', 1));
+	t1.push_back(TileKind('N', 3));
+	t1.push_back(TileKind('O', 7));
+	t1.push_back(TileKind('?', 1));
+	cpu2.add_tiles(t1);
+	cpu2.set_budget(chrono::milliseconds(0), 1000000000);
+	Move full = cpu2.get_move(b2, d);
+	EXPECT_TRUE(cpu2.get_search_complete());
+	// 6 10 | hit oaten
+	test_pts(b2.test_place(full), 38);
+}
+
+TEST_F(ComputerPlayerTest, cached_lines_match_full_search) {
+	Board b = Board::read("config/standard-board.txt");
+	Dictionary d = Dictionary::read(DICT_PATH);
+	d.build_gaddag();
+	TileBag bag = TileBag::read("config/english-tile-bag.txt", 54);
+	// one player keeps the same rack the whole game while another plays moves around it
+	ComputerPlayer watcher("watcher", 7);
+	ComputerPlayer opponent("opponent", 7);
+	watcher.set_engine(ComputerPlayer::Engine::GADDAG);
+	opponent.set_engine(ComputerPlayer::Engine::GADDAG);
+	watcher.add_tiles(bag.remove_random_tiles(7));
+	opponent.add_tiles(bag.remove_random_tiles(7));
+
+	size_t cached_nodes = 0;
+	size_t fresh_nodes = 0;
+	for (size_t turn = 0; turn < 8; turn++) {
+		ComputerPlayer fresh("fresh", 7);
+		fresh.set_engine(ComputerPlayer::Engine::GADDAG);
+		fresh.add_tiles(watcher.get_tiles());
+
+		vector<ComputerPlayer::RankedMove> expected = fresh.get_top_moves(b, d, 5);
+		vector<ComputerPlayer::RankedMove> cached = watcher.get_top_moves(b, d, 5);
+		ASSERT_EQ(cached.size(), expected.size());
+		for (size_t i = 0; i < expected.size(); i++) {
+			EXPECT_TRUE(same_move(cached[i].move, expected[i].move));
+			EXPECT_EQ(cached[i].points, expected[i].points);
+		}
+		EXPECT_LE(watcher.get_nodes_visited(), fresh.get_nodes_visited());
+		cached_nodes += watcher.get_nodes_visited();
+		fresh_nodes += fresh.get_nodes_visited();
+
+		// asking again without a change reuses every line
+		watcher.get_top_moves(b, d, 5);
+		EXPECT_EQ(watcher.get_nodes_visited(), 0);
+
+		Move m = opponent.get_move(b, d);
+		if (m.kind != MoveKind::PLACE || bag.count_tiles() < m.tiles.size())
+			break;
+		b.place(m);
+		opponent.remove_tiles(m.tiles);
+		opponent.add_tiles(bag.remove_random_tiles(m.tiles.size()));
+	}
+	EXPECT_LT(cached_nodes, fresh_nodes);
+}
+
+// Where each tile of a move ends up on the board, which is the same for two moves exactly when they place the same tiles
+string placement(const Board& b, const Move& m) {
+	string key;
+	Board::Position p(m.row, m.column);
+	for (const TileKind& t : m.tiles) {
+		while (b.in_bounds_and_has_tile(p))
+			p = p.translate(m.direction);
+		key += to_string(p.row) + ',' + to_string(p.column) + t.letter + t.assigned + ' ';
+		p = p.translate(m.direction);
+	}
+	return key;
+}
+
+TEST_F(ComputerPlayerTest, each_placement_once) {
+	Board b = Board::read("config/standard-board.txt");	
+	Dictionary d = Dictionary::read(DICT_PATH);
+	ComputerPlayer cpu("cpu", 7);
+
+	place_two_words(b);
+
+	vector<TileKind> t0;
+    t0.push_back(TileKind('A', 3));
+    t0.push_back(TileKind('B', 1));
+	t0.push_back(TileKind('F', 2));
+	t0.push_back(TileKind('T', 1));
+	t0.push_back(TileKind('N', 3));
+	t0.push_back(TileKind('O', 7));
+	t0.push_back(TileKind('?', 1));
+
+	cpu.add_tiles(t0);
+
+	vector<Move> moves = cpu.get_legal_moves(b, d);
+	set<string> placements;
+	for (const Move& m : moves) {
+		placements.insert(placement(b, m));
+	}
+	EXPECT_EQ(placements.size(), moves.size());
+	EXPECT_GT(cpu.get_duplicates_avoided(), 0);
+}
+
+TEST_F(ComputerPlayerTest, equity_with_leave_table) {
+	shared_ptr<LeaveTable> leaves = make_shared<LeaveTable>(LeaveTable::read("config/leaves.txt"));
+	EXPECT_NEAR(leaves->value("s"), 8.0, 1e-4);
+	EXPECT_NEAR(leaves->value("se"), 12.5, 1e-4);
+	EXPECT_EQ(LeaveTable::pack("ers"), LeaveTable::pack("sre"));
+	EXPECT_NE(LeaveTable::pack("es"), LeaveTable::pack("ess"));
+	EXPECT_NEAR(leaves->value(""), 0.0, 1e-4);
+	// not in the table, so the sum of the single tiles
+	EXPECT_NEAR(leaves->value("ab"), -1.0, 1e-4);
+
+	Board b = Board::read("config/standard-board.txt");	
+	Dictionary d = Dictionary::read(DICT_PATH);
+	d.build_gaddag();
+	ComputerPlayer cpu("cpu", 7);
+	cpu.set_engine(ComputerPlayer::Engine::GADDAG);
+
+	place_two_words(b);
+
+	vector<TileKind> t0;
+    t0.push_back(TileKind('A', 3));
+    t0.push_back(TileKind('S', 1));
+	t0.push_back(TileKind('F', 2));
+	t0.push_back(TileKind('T', 1));
+	t0.push_back(TileKind('N', 3));
+	t0.push_back(TileKind('O', 7));
+	t0.push_back(TileKind('?', 1));
+
+	cpu.add_tiles(t0);
+	cpu.set_leave_table(leaves);
+
+	// the best equity over every legal move
+	double best = -1e9;
+	for (const Move& m : cpu.get_legal_moves(b, d)) {
+		string leave = "asftno?";
+		for (const TileKind& t : m.tiles)
+			leave.erase(leave.find(t.letter), 1);
+		best = max(best, b.test_place(m).points + leaves->value(leave));
+	}
+
+	vector<ComputerPlayer::RankedMove> top = cpu.get_top_moves(b, d, 5);
+	ASSERT_EQ(top.size(), 5);
+	EXPECT_NEAR(top[0].equity, best, 1e-4);
+	for (size_t i = 1; i < top.size(); i++) {
+		EXPECT_GE(top[i - 1].equity, top[i].equity);
+	}
+
+	// without the table the equity is the score
+	cpu.set_leave_table(nullptr);
+	top = cpu.get_top_moves(b, d, 1);
+	EXPECT_EQ(top[0].equity, top[0].points);
+}
+
+TEST_F(ComputerPlayerTest, simulation) {
+	Board b = Board::read("config/small-board.txt");
+	Dictionary d = Dictionary::read(DICT_PATH);
+	d.build_gaddag();
+	TileBag bag = TileBag::read("config/small-tile-bag.txt", 3);
+	ComputerPlayer cpu("cpu", 5);
+	cpu.set_engine(ComputerPlayer::Engine::GADDAG);
+	cpu.add_tiles(bag.remove_random_tiles(5));
+	vector<TileKind> unseen;
+	for (auto it = bag.cbegin(); it != bag.cend(); ++it)
+		unseen.push_back(*it);
+	cpu.set_unseen_tiles(unseen, unseen.size());
+	cpu.set_simulation(3, 2, 6, 11);
+
+	vector<ComputerPlayer::RankedMove> top = cpu.get_top_moves(b, d, 3);
+	vector<ComputerPlayer::SimulatedMove> simulated = cpu.simulate(b, d);
+	ASSERT_EQ(simulated.size(), top.size());
+	for (size_t i = 0; i < top.size(); i++)
+		EXPECT_TRUE(same_move(simulated[i].ranked.move, top[i].move));
+	EXPECT_GT(cpu.get_playouts_per_second(), 0);
+
+	// the draws only depend on the seed, not on how the iterations are spread over threads
+	cpu.set_threads(3);
+	vector<ComputerPlayer::SimulatedMove> parallel = cpu.simulate(b, d);
+	ASSERT_EQ(parallel.size(), simulated.size());
+	for (size_t i = 0; i < simulated.size(); i++)
+		EXPECT_EQ(parallel[i].average, simulated[i].average);
+
+	size_t best = 0;
+	for (size_t i = 1; i < simulated.size(); i++)
+		if (simulated[i].average > simulated[best].average)
+			best = i;
+	EXPECT_TRUE(same_move(cpu.get_move(b, d), simulated[best].ranked.move));
+}
+
+TEST_F(ComputerPlayerTest, undo_place) {
+	Board b = Board::read("config/standard-board.txt");
+	Board original = b;
+	place_simple_word(b);
+	uint64_t hash = b.get_hash();
+	vector<uint64_t> stamps[2];
+	for (size_t row = 0; row < b.rows; row++)
+		stamps[0].push_back(b.get_line_stamp(Direction::ACROSS, row));
+	for (size_t column = 0; column < b.columns; column++)
+		stamps[1].push_back(b.get_line_stamp(Direction::DOWN, column));
+	vector<TileKind> t;
+	t.push_back(TileKind('S', 1));
+	b.place(Move(t, 8, 7, Direction::DOWN));
+	EXPECT_NE(b.get_hash(), hash);
+	EXPECT_NE(b.get_line_stamp(Direction::DOWN, 7), stamps[1][7]);
+
+	// a copy has nothing to take back
+	Board copy = b;
+	copy.undo_place();
+	EXPECT_EQ(copy.get_hash(), b.get_hash());
+
+	b.undo_place();
+	EXPECT_EQ(b.get_hash(), hash);
+	for (size_t row = 0; row < b.rows; row++)
+		EXPECT_EQ(b.get_line_stamp(Direction::ACROSS, row), stamps[0][row]);
+	for (size_t column = 0; column < b.columns; column++)
+		EXPECT_EQ(b.get_line_stamp(Direction::DOWN, column), stamps[1][column]);
+	EXPECT_FALSE(b.square_at(Board::Position(8, 7)).has_tile());
+	EXPECT_TRUE(b.square_at(Board::Position(7, 7)).has_tile());
+
+	b.undo_place();
+	EXPECT_EQ(b.get_hash(), original.get_hash());
+	for (size_t row = 0; row < b.rows; row++)
+		for (size_t column = 0; column < b.columns; column++)
+			EXPECT_FALSE(b.square_at(Board::Position(row, column)).has_tile());
+}
+
+TEST_F(ComputerPlayerTest, endgame_solver) {
+	Board b = Board::read("config/small-board.txt");
+	Dictionary d = Dictionary::read(DICT_PATH);
+	d.build_gaddag();
+	vector<TileKind> racks[2];
+	string letters[2] = {"seat", "digo"};
+	for (size_t i = 0; i < 2; i++)
+		for (size_t j = 0; j < letters[i].size(); j++)
+			racks[i].push_back(TileKind(letters[i][j], letters[i][j] == 'd' || letters[i][j] == 'g' ? 2 : 1));
+
+	EndgameSolver solver(d, ComputerPlayer::Engine::GADDAG, 5);
+	EndgameSolver::Result result = solver.solve(b, racks[0], racks[1], chrono::milliseconds(0));
+	ASSERT_TRUE(result.solved);
+	ASSERT_FALSE(result.sequence.empty());
+	EXPECT_GT(result.nodes, 0);
+
+	// playing the line out scores exactly the spread the solver promised
+	ComputerPlayer sides[2] = {ComputerPlayer("me", 5), ComputerPlayer("opponent", 5)};
+	int scores[2] = {0, 0};
+	for (size_t i = 0; i < 2; i++)
+		sides[i].add_tiles(racks[i]);
+	for (size_t i = 0; i < result.sequence.size(); i++) {
+		const Move& move = result.sequence[i];
+		if (move.kind == MoveKind::PASS)
+			continue;
+		PlaceResult placed = b.test_place(move);
+		ASSERT_TRUE(placed.valid);
+		for (size_t w = 0; w < placed.words.size(); w++)
+			EXPECT_TRUE(d.is_word(placed.words[w]));
+		scores[i % 2] += placed.points;
+		b.place(move);
+		sides[i % 2].remove_tiles(move.tiles);
+	}
+	// whoever goes out gains the other rack on top of the other side losing it
+	int spread = scores[0] - scores[1];
+	if (sides[0].count_tiles() == 0)
+		spread += 2 * sides[1].get_hand_value();
+	else if (sides[1].count_tiles() == 0)
+		spread -= 2 * sides[0].get_hand_value();
+	else
+		spread += sides[1].get_hand_value() - sides[0].get_hand_value();
+	EXPECT_EQ(spread, result.spread);
+
+	// with the bag empty get_move plays the solver's first move
+	Board empty = Board::read("config/small-board.txt");
+	ComputerPlayer cpu("cpu", 5);
+	cpu.set_engine(ComputerPlayer::Engine::GADDAG);
+	cpu.add_tiles(racks[0]);
+	cpu.set_unseen_tiles(racks[1], 0);
+	cpu.set_endgame_time(chrono::milliseconds(1000));
+	EXPECT_TRUE(same_move(cpu.get_move(empty, d), result.sequence[0]));
+}
+
+TEST_F(ComputerPlayerTest, pre_endgame) {
+	Board b = Board::read("config/small-board.txt");
+	Dictionary d = Dictionary::read(DICT_PATH);
+	d.build_gaddag();
+	auto tiles = [](const string& letters) {
+		vector<TileKind> t;
+		for (size_t i = 0; i < letters.size(); i++)
+			t.push_back(TileKind(letters[i], letters[i] == 'd' || letters[i] == 'g' ? 2 : 1));
+		return t;
+	};
+	ComputerPlayer cpu("cpu", 5);
+	cpu.set_engine(ComputerPlayer::Engine::GADDAG);
+	cpu.add_tiles(tiles("seat"));
+	// two of these are in the bag and the opponent holds the rest
+	cpu.set_unseen_tiles(tiles("digol"), 2);
+	cpu.set_endgame_time(chrono::milliseconds(60000));
+
+	vector<ComputerPlayer::SimulatedMove> solved = cpu.solve_pre_endgame(b, d);
+	vector<ComputerPlayer::RankedMove> top = cpu.get_top_moves(b, d, ComputerPlayer::PRE_ENDGAME_CANDIDATES);
+	ASSERT_EQ(solved.size(), top.size());
+	for (size_t i = 0; i < top.size(); i++)
+		EXPECT_TRUE(same_move(solved[i].ranked.move, top[i].move));
+	// every world was solved, and their probabilities add up to 1 for every candidate
+	EXPECT_NEAR(cpu.get_pre_endgame_coverage(), 1, 1e-9);
+
+	// solved exactly, the expectations do not depend on the thread count
+	cpu.set_threads(3);
+	vector<ComputerPlayer::SimulatedMove> parallel = cpu.solve_pre_endgame(b, d);
+	ASSERT_EQ(parallel.size(), solved.size());
+	for (size_t i = 0; i < solved.size(); i++)
+		EXPECT_NEAR(parallel[i].average, solved[i].average, 1e-9);
+
+	size_t best = 0;
+	for (size_t i = 1; i < solved.size(); i++)
+		if (solved[i].average > solved[best].average)
+			best = i;
+	EXPECT_TRUE(same_move(cpu.get_move(b, d), solved[best].ranked.move));
+}
+
+TEST_F(ComputerPlayerTest, exchange) {
+	shared_ptr<LeaveTable> leaves = make_shared<LeaveTable>(LeaveTable::read("config/leaves.txt"));
+	Board b = Board::read("config/standard-board.txt");
+	Dictionary d = Dictionary::read(DICT_PATH);
+	ComputerPlayer cpu("cpu", 7);
+	string letters = "quvvwws";
+	for (size_t i = 0; i < letters.size(); i++)
+		cpu.add_tiles(vector<TileKind>{TileKind(letters[i], 4)});
+
+	// no leave table, no exchange
+	EXPECT_EQ(cpu.get_best_exchange().move.kind, MoveKind::PASS);
+	cpu.set_leave_table(leaves);
+
+	// the best of every subset of the rack, duplicates and all
+	double best = -1e9;
+	for (size_t mask = 0; mask + 1 < (1u << letters.size()); mask++) {
+		string leave;
+		for (size_t i = 0; i < letters.size(); i++)
+			if (mask & (1u << i))
+				leave += letters[i];
+		best = max(best, leaves->value(leave));
+	}
+	ComputerPlayer::RankedMove exchange = cpu.get_best_exchange();
+	ASSERT_EQ(exchange.move.kind, MoveKind::EXCHANGE);
+	EXPECT_NEAR(exchange.equity, best, 1e-4);
+	string kept = letters;
+	for (const TileKind& t : exchange.move.tiles)
+		kept.erase(kept.find(t.letter), 1);
+	EXPECT_NEAR(leaves->value(kept), best, 1e-4);
+
+	// only with a full rack of tiles left in the bag
+	vector<ComputerPlayer::RankedMove> top = cpu.get_top_moves(b, d, 1);
+	ASSERT_FALSE(top.empty());
+	ASSERT_GT(exchange.equity, top[0].equity);
+	EXPECT_EQ(cpu.get_move(b, d).kind, MoveKind::PLACE);
+	cpu.set_unseen_tiles(vector<TileKind>(50, TileKind('e', 1)), 43);
+	EXPECT_EQ(cpu.get_move(b, d).kind, MoveKind::EXCHANGE);
+	cpu.set_unseen_tiles(vector<TileKind>(10, TileKind('e', 1)), 3);
+	EXPECT_NE(cpu.get_move(b, d).kind, MoveKind::EXCHANGE);
+}
+
+TEST_F(ComputerPlayerTest, pruned_search_matches_full_search) {
+	shared_ptr<LeaveTable> leaves = make_shared<LeaveTable>(LeaveTable::read("config/leaves.txt"));
+	Board b = Board::read("config/standard-board.txt");
+	Dictionary d = Dictionary::read(DICT_PATH);
+	d.build_gaddag();
+	TileBag bag = TileBag::read("config/english-tile-bag.txt", 54);
+	ComputerPlayer players[2] = {ComputerPlayer("one", 7), ComputerPlayer("two", 7)};
+	for (ComputerPlayer& p : players) {
+		p.set_engine(ComputerPlayer::Engine::GADDAG);
+		p.add_tiles(bag.remove_random_tiles(7));
+	}
+
+	size_t pruned_nodes = 0;
+	size_t full_nodes = 0;
+	size_t skipped = 0;
+	for (size_t turn = 0; turn < 8; turn++) {
+		ComputerPlayer& mover = players[turn % 2];
+		// the trie engine is too slow on the empty board
+		for (ComputerPlayer::Engine engine : {ComputerPlayer::Engine::TRIE, ComputerPlayer::Engine::GADDAG}) {
+			if (turn == 0 && engine == ComputerPlayer::Engine::TRIE)
+				continue;
+			for (shared_ptr<LeaveTable> table : {shared_ptr<LeaveTable>(), leaves}) {
+				ComputerPlayer full("full", 7);
+				ComputerPlayer pruned("pruned", 7);
+				full.set_engine(engine);
+				pruned.set_engine(engine);
+				full.set_pruning(false);
+				full.set_leave_table(table);
+				pruned.set_leave_table(table);
+				full.add_tiles(mover.get_tiles());
+				pruned.add_tiles(mover.get_tiles());
+
+				vector<ComputerPlayer::RankedMove> expected = full.get_top_moves(b, d, 1);
+				vector<ComputerPlayer::RankedMove> actual = pruned.get_top_moves(b, d, 1);
+				ASSERT_EQ(actual.size(), expected.size());
+				if (!expected.empty()) {
+					EXPECT_TRUE(same_move(actual[0].move, expected[0].move));
+					EXPECT_NEAR(actual[0].equity, expected[0].equity, 1e-4);
+				}
+				EXPECT_LE(pruned.get_nodes_visited(), full.get_nodes_visited());
+				EXPECT_EQ(full.get_anchors_skipped(), 0);
+				skipped += pruned.get_anchors_skipped();
+				pruned_nodes += pruned.get_nodes_visited();
+				full_nodes += full.get_nodes_visited();
+			}
+		}
+
+		Move m = mover.get_move(b, d);
+		if (m.kind != MoveKind::PLACE || bag.count_tiles() < m.tiles.size())
+			break;
+		b.place(m);
+		mover.remove_tiles(m.tiles);
+		mover.add_tiles(bag.remove_random_tiles(m.tiles.size()));
+	}
+	EXPECT_LT(pruned_nodes, full_nodes);
+	// the shadow bounds rule out whole anchors
+	EXPECT_GT(skipped, 0);
+}
+
+TEST_F(ComputerPlayerTest, blank_pruning) {
+	Board b = Board::read("config/standard-board.txt");
+	Dictionary d = Dictionary::read(DICT_PATH);
+	d.build_gaddag();
+	place_concave_words(b);
+	string letters = "se??";
+
+	for (ComputerPlayer::Engine engine : {ComputerPlayer::Engine::TRIE, ComputerPlayer::Engine::GADDAG}) {
+		ComputerPlayer full("full", 7);
+		ComputerPlayer pruned("pruned", 7);
+		full.set_engine(engine);
+		pruned.set_engine(engine);
+		full.set_blank_pruning(false);
+		for (size_t i = 0; i < letters.size(); i++) {
+			full.add_tiles(vector<TileKind>{TileKind(letters[i], 1)});
+			pruned.add_tiles(vector<TileKind>{TileKind(letters[i], 1)});
+		}
+
+		// exactly the moves that play a blank as a letter still left on the rack go
+		set<string> expected;
+		for (const ComputerPlayer::RankedMove& r : full.get_top_moves(b, d, SIZE_MAX)) {
+			string leave = letters;
+			for (const TileKind& t : r.move.tiles)
+				leave.erase(leave.find(t.letter), 1);
+			bool dominated = false;
+			for (const TileKind& t : r.move.tiles)
+				if (t.letter == '?' && leave.find(t.assigned) != string::npos)
+					dominated = true;
+			if (!dominated)
+				expected.insert(placement(b, r.move));
+		}
+		vector<ComputerPlayer::RankedMove> moves = pruned.get_top_moves(b, d, SIZE_MAX);
+		set<string> actual;
+		for (const ComputerPlayer::RankedMove& r : moves)
+			actual.insert(placement(b, r.move));
+		EXPECT_EQ(actual.size(), moves.size());
+		EXPECT_EQ(actual, expected);
+
+		// and none of them was the best
+		EXPECT_EQ(b.test_place(pruned.get_move(b, d)).points, b.test_place(full.get_move(b, d)).points);
+
+		// the legal moves are all still there
+		EXPECT_EQ(pruned.get_legal_moves(b, d).size(), full.get_legal_moves(b, d).size());
+
+		// and with a leave table, which may value keeping the blank either way, nothing is pruned
+		shared_ptr<LeaveTable> leaves = make_shared<LeaveTable>(LeaveTable::read("config/leaves.txt"));
+		full.set_leave_table(leaves);
+		pruned.set_leave_table(leaves);
+		EXPECT_EQ(pruned.get_top_moves(b, d, SIZE_MAX).size(), full.get_top_moves(b, d, SIZE_MAX).size());
+		EXPECT_EQ(pruned.get_top_moves(b, d, 1)[0].equity, full.get_top_moves(b, d, 1)[0].equity);
+	}
+}
+
+TEST_F(ComputerPlayerTest, pondering) {
+	Board b = Board::read("config/standard-board.txt");
+	Dictionary d = Dictionary::read(DICT_PATH);
+	d.build_gaddag();
+	place_concave_words(b);
+	TileBag bag = TileBag::read("config/english-tile-bag.txt", 54);
+	ComputerPlayer cpu("cpu", 7);
+	ComputerPlayer opponent("opponent", 7);
+	cpu.set_engine(ComputerPlayer::Engine::GADDAG);
+	opponent.set_engine(ComputerPlayer::Engine::GADDAG);
+	cpu.add_tiles(bag.remove_random_tiles(7));
+	opponent.add_tiles(bag.remove_random_tiles(7));
+
+	// what a player that never pondered would play
+	auto fresh_move = [&](const Board& board) {
+		ComputerPlayer fresh("fresh", 7);
+		fresh.set_engine(ComputerPlayer::Engine::GADDAG);
+		fresh.add_tiles(cpu.get_tiles());
+		return fresh.get_move(board, d);
+	};
+
+	// with the opponent's rack the only one left unseen, the reply it plays is predicted
+	cpu.set_unseen_tiles(opponent.get_tiles(), 0);
+	cpu.start_pondering(b, d);
+	cpu.finish_pondering();
+	Move reply = opponent.get_move(b, d);
+	ASSERT_EQ(reply.kind, MoveKind::PLACE);
+	b.place(reply);
+	Move m = cpu.get_move(b, d);
+	EXPECT_TRUE(cpu.get_ponder_hit());
+	EXPECT_TRUE(same_move(m, fresh_move(b)));
+
+	// a reply nobody predicted is searched from scratch
+	cpu.start_pondering(b, d);
+	cpu.finish_pondering();
+	ComputerPlayer other("other", 7);
+	other.set_engine(ComputerPlayer::Engine::GADDAG);
+	other.add_tiles(bag.remove_random_tiles(7));
+	reply = other.get_move(b, d);
+	ASSERT_EQ(reply.kind, MoveKind::PLACE);
+	ASSERT_TRUE(b.place(reply).valid);
+	m = cpu.get_move(b, d);
+	EXPECT_FALSE(cpu.get_ponder_hit());
+	EXPECT_TRUE(same_move(m, fresh_move(b)));
+
+	// and the answer to passing holds only for the same number of tiles in the bag
+	cpu.set_unseen_tiles(bag.remove_random_tiles(20), 13);
+	cpu.start_pondering(b, d);
+	cpu.finish_pondering();
+	cpu.get_move(b, d);
+	EXPECT_TRUE(cpu.get_ponder_hit());
+	cpu.start_pondering(b, d);
+	cpu.set_unseen_tiles(vector<TileKind>(20, TileKind('E', 1)), 12);
+	cpu.get_move(b, d);
+	EXPECT_FALSE(cpu.get_ponder_hit());
+
+	// nor does it hold once the player picks its moves differently, or for another dictionary
+	ComputerPlayer::Effort effort;
+	effort.greedy = true;
+	cpu.start_pondering(b, d);
+	cpu.finish_pondering();
+	cpu.set_effort(effort);
+	cpu.get_move(b, d);
+	EXPECT_FALSE(cpu.get_ponder_hit());
+	cpu.start_pondering(b, d);
+	cpu.finish_pondering();
+	cpu.set_leave_table(make_shared<LeaveTable>(LeaveTable::read("config/leaves.txt")));
+	cpu.get_move(b, d);
+	EXPECT_FALSE(cpu.get_ponder_hit());
+	cpu.start_pondering(b, d);
+	cpu.finish_pondering();
+	Dictionary without_gaddag = Dictionary::read(DICT_PATH);
+	cpu.get_move(b, without_gaddag);
+	EXPECT_FALSE(cpu.get_ponder_hit());
+	cpu.start_pondering(b, d);
+	cpu.finish_pondering();
+	cpu.get_move(b, d);
+	EXPECT_TRUE(cpu.get_ponder_hit());
+
+	// stopping does not wait for a slow search to finish, and the search it cut short leaves no answer behind
+	ComputerPlayer slow("slow", 7);
+	for (char letter : string("ae?st?r"))
+		slow.add_tiles(vector<TileKind>{TileKind(letter, letter == '?' ? 0 : 1)});
+	slow.set_unseen_tiles(opponent.get_tiles(), 0);
+	ComputerPlayer fresh("fresh", 7);
+	fresh.add_tiles(slow.get_tiles());
+	auto start = chrono::steady_clock::now();
+	Move best = fresh.get_move(b, d);
+	auto full = chrono::steady_clock::now() - start;
+	slow.start_pondering(b, d);
+	this_thread::sleep_for(full / 10);
+	start = chrono::steady_clock::now();
+	slow.stop_pondering();
+	EXPECT_LT(chrono::steady_clock::now() - start, full / 4);
+	EXPECT_TRUE(same_move(slow.get_move(b, d), best));
+	EXPECT_FALSE(slow.get_ponder_hit());
+}
+
+TEST_F(ComputerPlayerTest, opening_book) {
+	shared_ptr<LeaveTable> leaves = make_shared<LeaveTable>(LeaveTable::read("config/leaves.txt"));
+	Board b = Board::read("config/standard-board.txt");
+	Dictionary d = Dictionary::read(DICT_PATH);
+	d.build_gaddag();
+	TileBag bag = TileBag::read("config/english-tile-bag.txt", 54);
+	ComputerPlayer cpu("cpu", 7);
+	cpu.set_engine(ComputerPlayer::Engine::GADDAG);
+	cpu.set_leave_table(leaves);
+
+	// fill a book for a few racks, and take it through a file
+	OpeningBook filled(b, 3);
+	vector<vector<TileKind>> racks;
+	vector<vector<ComputerPlayer::RankedMove>> expected;
+	for (size_t i = 0; i < 4; i++) {
+		racks.push_back(bag.remove_random_tiles(7));
+		cpu.remove_tiles(cpu.get_tiles());
+		cpu.add_tiles(racks.back());
+		expected.push_back(cpu.get_top_moves(b, d, 3));
+		vector<Move> moves;
+		for (const ComputerPlayer::RankedMove& r : expected.back())
+			moves.push_back(r.move);
+		filled.add(racks.back(), moves);
+	}
+	// the key does not depend on the order of the tiles
+	vector<TileKind> shuffled(racks[0].rbegin(), racks[0].rend());
+	EXPECT_EQ(OpeningBook::rack_key(shuffled), OpeningBook::rack_key(racks[0]));
+	filled.write("opening_book_test.txt");
+	shared_ptr<OpeningBook> book = make_shared<OpeningBook>(OpeningBook::read("opening_book_test.txt"));
+	remove("opening_book_test.txt");
+	EXPECT_EQ(book->size(), 4);
+	EXPECT_EQ(book->get_fingerprint(), filled.get_fingerprint());
+
+	cpu.set_opening_book(book);
+	for (size_t i = 0; i < racks.size(); i++) {
+		cpu.remove_tiles(cpu.get_tiles());
+		cpu.add_tiles(racks[i]);
+		vector<ComputerPlayer::RankedMove> top = cpu.get_top_moves(b, d, 2);
+		EXPECT_EQ(cpu.get_nodes_visited(), 0);
+		ASSERT_EQ(top.size(), 2);
+		for (size_t j = 0; j < top.size(); j++) {
+			EXPECT_TRUE(same_move(top[j].move, expected[i][j].move));
+			EXPECT_EQ(top[j].points, expected[i][j].points);
+			EXPECT_NEAR(top[j].equity, expected[i][j].equity, 1e-4);
+		}
+	}
+
+	// more moves than the book keeps, a rack it does not hold, or any other board are searched
+	cpu.get_top_moves(b, d, 4);
+	EXPECT_GT(cpu.get_nodes_visited(), 0);
+	cpu.remove_tiles(cpu.get_tiles());
+	cpu.add_tiles(bag.remove_random_tiles(7));
+	cpu.get_move(b, d);
+	EXPECT_GT(cpu.get_nodes_visited(), 0);
+	cpu.remove_tiles(cpu.get_tiles());
+	cpu.add_tiles(racks[0]);
+	EXPECT_TRUE(book->find(Board::read("config/small-board.txt"), racks[0]).empty());
+	Move first = cpu.get_move(b, d);
+	EXPECT_EQ(cpu.get_nodes_visited(), 0);
+	b.place(first);
+	EXPECT_TRUE(book->find(b, racks[0]).empty());
+}
+
+TEST_F(ComputerPlayerTest, transposition_cache) {
+	shared_ptr<LeaveTable> leaves = make_shared<LeaveTable>(LeaveTable::read("config/leaves.txt"));
+	Board b = Board::read("config/standard-board.txt");
+	Dictionary d = Dictionary::read(DICT_PATH);
+	d.build_gaddag();
+	place_concave_words(b);
+	TileBag bag = TileBag::read("config/english-tile-bag.txt", 54);
+	vector<TileKind> rack = bag.remove_random_tiles(7);
+	shared_ptr<TranspositionCache> cache = make_shared<TranspositionCache>(1000);
+	EXPECT_EQ(cache->size(), 1024);
+
+	auto make_player = [&](const vector<TileKind>& tiles) {
+		ComputerPlayer cpu("cpu", 7);
+		cpu.set_engine(ComputerPlayer::Engine::GADDAG);
+		cpu.set_leave_table(leaves);
+		cpu.set_transposition_cache(cache);
+		cpu.add_tiles(tiles);
+		return cpu;
+	};
+
+	// a search is stored, and a second player with the same tiles in another order finds it without searching
+	ComputerPlayer first = make_player(rack);
+	vector<ComputerPlayer::RankedMove> searched = first.get_top_moves(b, d, 3);
+	EXPECT_GT(first.get_nodes_visited(), 0);
+	ComputerPlayer second = make_player(vector<TileKind>(rack.rbegin(), rack.rend()));
+	vector<ComputerPlayer::RankedMove> found = second.get_top_moves(b, d, 2);
+	EXPECT_EQ(second.get_nodes_visited(), 0);
+	ASSERT_EQ(found.size(), 2);
+	for (size_t i = 0; i < found.size(); i++) {
+		EXPECT_TRUE(same_move(found[i].move, searched[i].move));
+		EXPECT_EQ(found[i].points, searched[i].points);
+		EXPECT_EQ(found[i].words, searched[i].words);
+		EXPECT_EQ(found[i].equity, searched[i].equity);
+	}
+	TranspositionCache::Stats stats = cache->get_stats();
+	EXPECT_EQ(stats.hits, 1);
+	EXPECT_EQ(stats.misses, 1);
+	EXPECT_EQ(stats.stores, 1);
+
+	// more moves than were stored, another board, or another leave table are searched
+	second.get_top_moves(b, d, 4);
+	EXPECT_GT(second.get_nodes_visited(), 0);
+	Board changed = b;
+	changed.place(searched[0].move);
+	second.get_top_moves(changed, d, 1);
+	EXPECT_GT(second.get_nodes_visited(), 0);
+	second.set_leave_table(nullptr);
+	second.get_top_moves(b, d, 1);
+	EXPECT_GT(second.get_nodes_visited(), 0);
+	stats = cache->get_stats();
+	EXPECT_EQ(stats.hits, 1);
+	EXPECT_EQ(stats.misses, 4);
+	cache->reset_stats();
+	EXPECT_EQ(cache->get_stats().misses, 0);
+
+	// get_move finds the move its own search would have
+	ComputerPlayer third = make_player(rack);
+	EXPECT_TRUE(same_move(third.get_move(changed, d), make_player(rack).get_move(changed, d)));
+	EXPECT_EQ(third.get_nodes_visited(), 0);
+
+	// the dictionary and leave table are told apart by what they hold, not where they are
+	EXPECT_EQ(Dictionary::read(DICT_PATH).get_fingerprint(), d.get_fingerprint());
+	EXPECT_NE(d.get_fingerprint(), 0);
+	ComputerPlayer fourth = make_player(rack);
+	fourth.set_leave_table(make_shared<LeaveTable>(LeaveTable::read("config/leaves.txt")));
+	EXPECT_EQ(fourth.get_top_moves(changed, d, 1).size(), 1);
+	EXPECT_EQ(fourth.get_nodes_visited(), 0);
+}
+
+TEST_F(ComputerPlayerTest, transposition_cache_threads) {
+	// many threads hammering a few slots only ever find the moves stored for the position they ask for
+	TranspositionCache cache(4);
+	vector<TileKind> rack = {TileKind('a', 1), TileKind('b', 3), TileKind('?', 0)};
+	auto moves_for = [&](uint64_t position) {
+		vector<TranspositionCache::Hit> moves;
+		for (size_t i = 0; i < 3; i++) {
+			TileKind blank('?', 0, 'a' + position % 26);
+			Move move({rack[i % 2], blank}, position % 15, i, Direction::DOWN);
+			moves.push_back(TranspositionCache::Hit{move, position + i, position * 0.5 - i});
+		}
+		return moves;
+	};
+
+	std::atomic<size_t> wrong{0};
+	vector<thread> threads;
+	for (size_t t = 0; t < 4; t++) {
+		threads.emplace_back([&, t]() {
+			vector<TranspositionCache::Hit> found;
+			for (uint64_t i = 0; i < 20000; i++) {
+				uint64_t position = (i * 7 + t) % 64;
+				if (cache.find(position, rack, 1, 3, found)) {
+					vector<TranspositionCache::Hit> expected = moves_for(position);
+					for (size_t m = 0; m < found.size(); m++) {
+						if (!same_move(found[m].move, expected[m].move) || found[m].points != expected[m].points
+							|| found[m].equity != expected[m].equity) {
+							wrong++;
+						}
+					}
+					if (found.size() != 3) {
+						wrong++;
+					}
+				} else {
+					cache.store(position, rack, 1, 3, moves_for(position));
+				}
+			}
+		});
+	}
+	for (thread& t : threads) {
+		t.join();
+	}
+	EXPECT_EQ(wrong, 0);
+	TranspositionCache::Stats stats = cache.get_stats();
+	EXPECT_EQ(stats.hits + stats.misses, 80000);
+	EXPECT_GT(stats.hits, 0);
+	EXPECT_EQ(stats.stores + stats.dropped, stats.misses);
+}
+
+TEST_F(ComputerPlayerTest, compact_move) {
+	EXPECT_TRUE(is_trivially_copyable<CompactMove>::value);
+	EXPECT_LE(sizeof(CompactMove), 24);
+
+	// every kind of move, blanks included, converts and comes back the same
+	vector<TileKind> tiles = {TileKind('c', 3), TileKind('?', 0, 'a'), TileKind('t', 1), TileKind('?', 0, 'S')};
+	vector<Move> moves = {Move(tiles, 7, 4, Direction::DOWN), Move(tiles), Move()};
+	for (const Move& move : moves) {
+		ASSERT_TRUE(CompactMove::fits(move));
+		CompactMove compact(move);
+		Move back = compact.to_move();
+		EXPECT_TRUE(same_move(back, move));
+		EXPECT_EQ(back.row, move.row);
+		EXPECT_EQ(back.column, move.column);
+		EXPECT_EQ(back.direction, move.direction);
+		for (size_t i = 0; i < move.tiles.size(); i++) {
+			EXPECT_EQ(back.tiles[i].points, move.tiles[i].points);
+		}
+		CompactMove again(back);
+		EXPECT_EQ(memcmp(&compact, &again, sizeof(CompactMove)), 0);
+	}
+	CompactMove compact(moves[0]);
+	EXPECT_EQ(compact.size, 4);
+	EXPECT_EQ(compact.blanks, 0b1010);
+	compact.pop_back();
+	EXPECT_EQ(compact.blanks, 0b0010);
+	EXPECT_EQ(compact.tile(2).letter, 't');
+
+	// too many tiles, or too far off the corner, do not fit
+	EXPECT_FALSE(CompactMove::fits(Move(vector<TileKind>(9, TileKind('e', 1)))));
+	EXPECT_FALSE(CompactMove::fits(Move(tiles, 300, 0, Direction::ACROSS)));
+}
+
+TEST_F(ComputerPlayerTest, long_moves) {
+	// a hand bigger than a CompactMove holds still plays all of itself, with either engine and any search
+	Board b = Board::read("config/standard-board.txt");
+	Dictionary d = Dictionary::read(DICT_PATH);
+	d.build_gaddag();
+	for (ComputerPlayer::Engine engine : {ComputerPlayer::Engine::TRIE, ComputerPlayer::Engine::GADDAG}) {
+		ComputerPlayer cpu("cpu", 9);
+		cpu.set_engine(engine);
+		for (char letter : string("abandoned"))
+			cpu.add_tiles(vector<TileKind>{TileKind(letter, 1)});
+		Move best = cpu.get_move(b, d);
+		ASSERT_EQ(best.kind, MoveKind::PLACE);
+		EXPECT_EQ(best.tiles.size(), 9);
+		EXPECT_FALSE(CompactMove::fits(best));
+		EXPECT_EQ(b.test_place(best).points, 27);
+
+		size_t longest = 0;
+		for (const Move& move : cpu.get_legal_moves(b, d))
+			longest = max(longest, move.tiles.size());
+		EXPECT_EQ(longest, 9);
+		ComputerPlayer::MoveEnumerator moves = cpu.enumerate_moves(b, d);
+		Move move;
+		longest = 0;
+		while (moves.next(move))
+			longest = max(longest, move.tiles.size());
+		EXPECT_EQ(longest, 9);
+	}
+}
+
+TEST_F(ComputerPlayerTest, lookahead) {
+	Board b = Board::read("config/standard-board.txt");
+	Dictionary d = Dictionary::read(DICT_PATH);
+	d.build_gaddag();
+	place_concave_words(b);
+	TileBag bag = TileBag::read("config/english-tile-bag.txt", 7);
+	ComputerPlayer cpu("cpu", 7);
+	cpu.set_engine(ComputerPlayer::Engine::GADDAG);
+	cpu.add_tiles(bag.remove_random_tiles(7));
+	ComputerPlayer opponent("opponent", 7);
+	opponent.set_engine(ComputerPlayer::Engine::GADDAG);
+	opponent.add_tiles(bag.remove_random_tiles(7));
+
+	// with the opponent's rack the only tiles unseen, every sample is that rack, and the reply is its best move
+	cpu.set_unseen_tiles(opponent.get_tiles(), 0);
+	cpu.set_lookahead(4, 5, chrono::milliseconds(0), 3);
+	vector<ComputerPlayer::RankedMove> top = cpu.get_top_moves(b, d, 4);
+	vector<ComputerPlayer::SimulatedMove> weighed = cpu.look_ahead(b, d);
+	ASSERT_EQ(weighed.size(), top.size());
+	EXPECT_EQ(cpu.get_lookahead_coverage(), 1);
+	for (size_t i = 0; i < top.size(); i++) {
+		EXPECT_TRUE(same_move(weighed[i].ranked.move, top[i].move));
+		Board after = b;
+		after.place(top[i].move);
+		vector<ComputerPlayer::RankedMove> reply = opponent.get_top_moves(after, d, 1);
+		ASSERT_EQ(reply.size(), 1);
+		size_t points = reply[0].points + (reply[0].move.tiles.size() == 7 ? ComputerPlayer::BINGO_BONUS : 0);
+		EXPECT_DOUBLE_EQ(weighed[i].average, top[i].equity - points);
+	}
+
+	// sampled racks only depend on the seed, not on how the candidates are spread over threads
+	vector<TileKind> unseen;
+	for (auto it = bag.cbegin(); it != bag.cend(); ++it)
+		unseen.push_back(*it);
+	cpu.set_unseen_tiles(unseen, unseen.size() - 7);
+	weighed = cpu.look_ahead(b, d);
+	cpu.set_threads(3);
+	vector<ComputerPlayer::SimulatedMove> parallel = cpu.look_ahead(b, d);
+	ASSERT_EQ(parallel.size(), weighed.size());
+	for (size_t i = 0; i < weighed.size(); i++)
+		EXPECT_EQ(parallel[i].average, weighed[i].average);
+
+	size_t best = 0;
+	for (size_t i = 1; i < weighed.size(); i++)
+		if (weighed[i].average > weighed[best].average)
+			best = i;
+	EXPECT_TRUE(same_move(cpu.get_move(b, d), weighed[best].ranked.move));
+
+	// a time cap still leaves a move to play
+	cpu.set_lookahead(4, 1000, chrono::milliseconds(20), 3);
+	EXPECT_EQ(cpu.get_move(b, d).kind, MoveKind::PLACE);
+	EXPECT_LT(cpu.get_lookahead_coverage(), 1);
+}
+
+TEST_F(ComputerPlayerTest, search_stats) {
+	Board b = Board::read("config/standard-board.txt");
+	Dictionary d = Dictionary::read(DICT_PATH);
+	place_concave_words(b);
+	ComputerPlayer cpu("cpu", 7);
+	TileBag bag = TileBag::read("config/english-tile-bag.txt", 7);
+	cpu.add_tiles(bag.remove_random_tiles(7));
+	ostringstream log;
+	cpu.set_instrumentation(true, &log);
+
+	cpu.get_move(b, d);
+	const ComputerPlayer::SearchStats& stats = cpu.get_search_stats();
+	EXPECT_GT(stats.anchors, 0);
+	EXPECT_EQ(stats.nodes, cpu.get_nodes_visited());
+	EXPECT_GT(stats.rack_lookups, 0);
+	EXPECT_GT(stats.candidates, 0);
+	EXPECT_LE(stats.placements_tested, stats.candidates);
+	EXPECT_GE(stats.word_checks, stats.words_rejected);
+	EXPECT_GT(stats.scoring_time.count(), 0);
+	EXPECT_GE(stats.total_time, stats.search_time);
+
+	// one line per move, and the counts start over every move
+	size_t anchors = stats.anchors;
+	cpu.get_move(b, d);
+	EXPECT_EQ(cpu.get_search_stats().anchors, anchors);
+	string lines = log.str();
+	EXPECT_EQ(count(lines.begin(), lines.end(), '\n'), 2);
+
+	// without instrumentation nothing is timed per move, but everything is still counted
+	cpu.set_instrumentation(false);
+	cpu.get_move(b, d);
+	EXPECT_EQ(cpu.get_search_stats().scoring_time.count(), 0);
+	EXPECT_EQ(cpu.get_search_stats().anchors, anchors);
+	EXPECT_EQ(log.str(), lines);
+}
+
+TEST_F(ComputerPlayerTest, effort) {
+	Board b = Board::read("config/standard-board.txt");
+	Dictionary d = Dictionary::read(DICT_PATH);
+	d.build_gaddag();
+	place_concave_words(b);
+	TileBag bag = TileBag::read("config/english-tile-bag.txt", 11);
+	vector<TileKind> rack = bag.remove_random_tiles(7);
+	ComputerPlayer full("full", 7);
+	full.set_engine(ComputerPlayer::Engine::GADDAG);
+	full.add_tiles(rack);
+	Move best = full.get_move(b, d);
+	size_t best_points = b.test_place(best).points;
+	size_t full_nodes = full.get_nodes_visited();
+
+	// a cap the search never reaches changes nothing
+	ComputerPlayer::Effort effort;
+	EXPECT_FALSE(effort.capped());
+	effort.anchor_nodes = 1000000;
+	ComputerPlayer cpu("cpu", 7);
+	cpu.set_engine(ComputerPlayer::Engine::GADDAG);
+	cpu.add_tiles(rack);
+	cpu.set_effort(effort);
+	EXPECT_TRUE(same_move(cpu.get_move(b, d), best));
+	EXPECT_TRUE(cpu.get_search_complete());
+
+	// every cap finds a valid move with fewer nodes, and the same one on any number of threads
+	ComputerPlayer::Effort efforts[3];
+	efforts[0].anchor_nodes = 16;
+	efforts[1].good_enough = 10;
+	efforts[2].greedy = true;
+	for (const ComputerPlayer::Effort& capped : efforts) {
+		cpu.set_threads(1);
+		cpu.set_effort(capped);
+		Move move = cpu.get_move(b, d);
+		PlaceResult result = b.test_place(move);
+		ASSERT_TRUE(result.valid);
+		EXPECT_LE(result.points, best_points);
+		EXPECT_LT(cpu.get_nodes_visited(), full_nodes);
+		EXPECT_FALSE(cpu.get_search_complete());
+		if (capped.good_enough > 0) {
+			EXPECT_GE(result.points, capped.good_enough);
+		}
+		cpu.set_threads(3);
+		EXPECT_TRUE(same_move(cpu.get_move(b, d), move));
+	}
+
+	// a cut short search leaves nothing behind in the line cache for the full search to trust
+	cpu.set_effort(ComputerPlayer::Effort());
+	EXPECT_TRUE(same_move(cpu.get_move(b, d), best));
+}
+
+TEST(LatencyHistogramTest, percentiles) {
+	LatencyHistogram latencies;
+	EXPECT_EQ(latencies.percentile(0.5).count(), 0);
+	for (int i = 1000; i >= 1; i--)
+		latencies.record(chrono::microseconds(i));
+	EXPECT_EQ(latencies.count(), 1000);
+	EXPECT_EQ(latencies.max().count(), 1000);
+	EXPECT_EQ(latencies.percentile(1).count(), 1000);
+	EXPECT_EQ(latencies.percentile(0.001).count(), 1);
+	// a percentile is rounded up to the end of its bucket, at most an eighth more
+	EXPECT_GE(latencies.percentile(0.5).count(), 500);
+	EXPECT_LE(latencies.percentile(0.5).count(), 500 + 500 / 8);
+	EXPECT_GE(latencies.percentile(0.99).count(), 990);
+	EXPECT_LE(latencies.percentile(0.99).count(), 1000);
+	latencies.record(chrono::hours(2));
+	EXPECT_EQ(latencies.max(), chrono::hours(2));
+}
+
+TEST_F(ComputerPlayerTest, hints) {
+	Board b = Board::read("config/standard-board.txt");
+	Dictionary d = Dictionary::read(DICT_PATH);
+	place_concave_words(b);
+	TileBag bag = TileBag::read("config/english-tile-bag.txt", 5);
+	HumanPlayer human("human", 7);
+	human.add_tiles(bag.remove_random_tiles(7));
+	EXPECT_TRUE(human.get_hints(b, d).empty());
+
+	ComputerPlayer cpu("cpu", 7);
+	cpu.add_tiles(human.get_tiles());
+	vector<ComputerPlayer::RankedMove> top = cpu.get_top_moves(b, d, 3);
+
+	// with time to spare the hints are the best moves, for whatever rack the player holds at the time
+	human.set_hints(make_shared<ComputerPlayer>("hints", 7), 3, chrono::milliseconds(10000));
+	vector<ComputerPlayer::RankedMove> hints = human.get_hints(b, d);
+	ASSERT_EQ(hints.size(), top.size());
+	for (size_t i = 0; i < hints.size(); i++)
+		EXPECT_TRUE(same_move(hints[i].move, top[i].move));
+	human.remove_tiles(human.get_tiles());
+	human.add_tiles(bag.remove_random_tiles(7));
+	cpu.remove_tiles(cpu.get_tiles());
+	cpu.add_tiles(human.get_tiles());
+	EXPECT_TRUE(same_move(human.get_hints(b, d)[0].move, cpu.get_move(b, d)));
+	EXPECT_EQ(human.get_hint_latency().count(), 2);
+	EXPECT_GE(human.get_hint_latency().max(), human.get_hint_latency().percentile(0.5));
+}
+
+TEST_F(ComputerPlayerTest, batch_scorer) {
+	Board b = Board::read("config/standard-board.txt");
+	Dictionary d = Dictionary::read(DICT_PATH);
+	place_concave_words(b);
+	ComputerPlayer cpu("cpu", 7);
+	TileBag bag = TileBag::read("config/english-tile-bag.txt", 2);
+	vector<TileKind> rack = bag.remove_random_tiles(6);
+	rack.push_back(TileKind(TileKind::BLANK_LETTER, 0));
+	cpu.add_tiles(rack);
+
+	// every legal move scores what test_place gives it, however many moves a batch holds
+	vector<CompactMove> moves;
+	for (const Move& move : cpu.get_legal_moves(b, d))
+		moves.push_back(CompactMove(move));
+	ASSERT_GT(moves.size(), 3 * BatchScorer::LANES);
+	moves.resize(moves.size() / BatchScorer::LANES * BatchScorer::LANES + 3);
+	BatchScorer scorer(b);
+	vector<unsigned int> scores = scorer.score(moves);
+	ASSERT_EQ(scores.size(), moves.size());
+	for (size_t i = 0; i < moves.size(); i++)
+		EXPECT_EQ(scores[i], b.test_place(moves[i].to_move()).points);
+
+	// moves that do not fit on the board, or start on a tile, score nothing
+	vector<CompactMove> misfits(3, moves[0]);
+	misfits[0].row = b.rows;
+	misfits[1].direction = Direction::ACROSS;
+	misfits[1].column = b.columns - 1;
+	misfits[1].row = 0;
+	misfits[1].push_back(TileKind('a', 1));
+	misfits[2].row = 7;
+	misfits[2].column = 7;
+	ASSERT_TRUE(b.in_bounds_and_has_tile(Board::Position(7, 7)));
+	EXPECT_EQ(scorer.score(misfits), vector<unsigned int>(3, 0));
+	EXPECT_TRUE(scorer.score(vector<CompactMove>()).empty());
+}
+
+TEST_F(ComputerPlayerTest, enumerate_moves) {
+	Board b = Board::read("config/standard-board.txt");
+	Dictionary d = Dictionary::read(DICT_PATH);
+	d.build_gaddag();
+	place_concave_words(b);
+	TileBag bag = TileBag::read("config/english-tile-bag.txt", 9);
+	ComputerPlayer cpu("cpu", 7);
+	vector<TileKind> rack = bag.remove_random_tiles(6);
+	rack.push_back(TileKind(TileKind::BLANK_LETTER, 0));
+	cpu.add_tiles(rack);
+	cpu.set_engine(ComputerPlayer::Engine::GADDAG);
+	vector<Move> legal = cpu.get_legal_moves(b, d);
+
+	// the same moves in the same order, for the same nodes, and the rack of the player is left alone
+	ComputerPlayer::MoveEnumerator moves = cpu.enumerate_moves(b, d);
+	Move move;
+	size_t i = 0;
+	while (moves.next(move)) {
+		ASSERT_LT(i, legal.size());
+		EXPECT_TRUE(same_move(move, legal[i]));
+		i++;
+	}
+	EXPECT_EQ(i, legal.size());
+	EXPECT_EQ(moves.get_nodes_visited(), cpu.get_nodes_visited());
+	EXPECT_FALSE(moves.next(move));
+	EXPECT_EQ(cpu.get_tiles().size(), 7);
+
+	// stopping early only costs the nodes searched so far
+	ComputerPlayer::MoveEnumerator first = cpu.enumerate_moves(b, d);
+	ASSERT_TRUE(first.next(move));
+	EXPECT_TRUE(same_move(move, legal[0]));
+	EXPECT_LT(first.get_nodes_visited(), cpu.get_nodes_visited());
+}
+
+TEST_F(ComputerPlayerTest, strategy) {
+	Board b = Board::read("config/standard-board.txt");
+	Dictionary d = Dictionary::read(DICT_PATH);
+	d.build_gaddag();
+	place_concave_words(b);
+	shared_ptr<LeaveTable> leaves = make_shared<LeaveTable>(LeaveTable::read("config/leaves.txt"));
+	TileBag bag = TileBag::read("config/english-tile-bag.txt", 13);
+	vector<TileKind> rack = bag.remove_random_tiles(7);
+
+	ComputerPlayer greedy("greedy", 7);
+	greedy.set_engine(ComputerPlayer::Engine::GADDAG);
+	greedy.add_tiles(rack);
+	Move by_points = greedy.get_move(b, d);
+	ComputerPlayer equity = greedy;
+	equity.set_leave_table(leaves);
+	Move by_equity = equity.get_move(b, d);
+
+	// a strategy picks what a player set up the same way would, whatever the player itself is set up to do
+	ComputerPlayer cpu("cpu", 7);
+	cpu.set_engine(ComputerPlayer::Engine::GADDAG);
+	cpu.set_leave_table(leaves);
+	cpu.add_tiles(rack);
+	EXPECT_EQ(cpu.get_strategy(), nullptr);
+	shared_ptr<Strategy> strategy = make_shared<GreedyStrategy>();
+	EXPECT_EQ(strategy->get_name(), "greedy");
+	cpu.set_strategy(strategy);
+	EXPECT_TRUE(same_move(cpu.get_move(b, d), by_points));
+	cpu.set_strategy(make_shared<EquityStrategy>(leaves));
+	EXPECT_TRUE(same_move(cpu.get_move(b, d), by_equity));
+	ComputerPlayer::Effort effort;
+	effort.anchor_nodes = 1000000;
+	cpu.set_strategy(make_shared<CappedStrategy>(effort, leaves));
+	EXPECT_TRUE(same_move(cpu.get_move(b, d), by_equity));
+	EXPECT_EQ(cpu.get_tiles().size(), 7);
+
+	// one strategy serves any number of players, and nullptr hands the move back to the player
+	greedy.set_strategy(strategy);
+	EXPECT_TRUE(same_move(greedy.get_move(b, d), by_points));
+	cpu.set_strategy(nullptr);
+	EXPECT_TRUE(same_move(cpu.get_move(b, d), by_equity));
+
+	// the player's chooser is kept from move to move, but always picks for the rack the player holds now
+	vector<TileKind> next_rack = bag.remove_random_tiles(7);
+	ComputerPlayer fresh("fresh", 7);
+	fresh.set_engine(ComputerPlayer::Engine::GADDAG);
+	fresh.add_tiles(next_rack);
+	greedy.remove_tiles(rack);
+	greedy.add_tiles(next_rack);
+	EXPECT_TRUE(same_move(greedy.get_move(b, d), fresh.get_move(b, d)));
+	EXPECT_EQ(greedy.get_tiles().size(), 7);
+	EXPECT_TRUE(greedy.get_search_complete());
+
+	// and searches with the player's budget
+	greedy.set_budget(chrono::milliseconds(0), 1);
+	greedy.get_move(b, d);
+	EXPECT_FALSE(greedy.get_search_complete());
+	EXPECT_GT(greedy.get_nodes_visited(), 0);
+}
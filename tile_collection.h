@@ -2,6 +2,7 @@
 #define TILE_COLLECTION_H
 
 #include "tile_kind.h"
+#include <cstddef>
 #include <map>
 #include <vector>
 
@@ -35,8 +36,10 @@ class TileCollection {
         typedef TileKind* pointer;
         typedef int difference_type;
         typedef std::forward_iterator_tag iterator_category;
-        const_iterator(TileMap::const_iterator it) : map_itr(it), temp('\0', 0) {
-            while (map_itr->second == 0)  // if amount is 0, pair should have been erased. This is a second check.
+        const_iterator(TileMap::const_iterator it, TileMap::const_iterator end)
+                : map_itr(it), map_end(end), temp('\0', 0) {
+            // if amount is 0, pair should have been erased. This is a second check.
+            while (map_itr != map_end && map_itr->second == 0)
                 map_itr++;
         }
         self_type operator++();
@@ -52,6 +55,7 @@ class TileCollection {
       private:
         size_t repeat_count = 0;
         TileMap::const_iterator map_itr;
+        TileMap::const_iterator map_end;
         TileKind temp;
     };
 
@@ -0,0 +1,127 @@
+#include "transposition_cache.h"
+
+#include "zobrist.h"
+#include <algorithm>
+#include <cstring>
+
+using namespace std;
+
+TranspositionCache::TranspositionCache(size_t slots) : slot_count(1) {
+    while (slot_count < slots) {
+        slot_count *= 2;
+    }
+    this->slots.reset(new Slot[slot_count]());
+}
+
+uint64_t TranspositionCache::rack_key(const vector<TileKind>& rack) {
+    vector<unsigned char> letters;
+    for (const TileKind& tile : rack) {
+        letters.push_back(tile.letter);
+    }
+    sort(letters.begin(), letters.end());
+    uint64_t key = 0;
+    for (unsigned char letter : letters) {
+        key = key << 8 | letter;
+    }
+    return key;
+}
+
+TranspositionCache::Slot& TranspositionCache::slot_for(uint64_t board_hash, uint64_t rack, uint64_t context) const {
+    return slots[zobrist_key(board_hash ^ zobrist_key(rack ^ zobrist_key(context))) & (slot_count - 1)];
+}
+
+bool TranspositionCache::find(
+        uint64_t board_hash, const vector<TileKind>& rack, uint64_t context, size_t count, vector<Hit>& moves) const {
+    moves.clear();
+    if (rack.size() > MAX_TILES) {
+        misses.fetch_add(1, memory_order_relaxed);
+        return false;
+    }
+    uint64_t key = rack_key(rack);
+    Slot& slot = slot_for(board_hash, key, context);
+
+    // copy the slot out, then make sure no writer touched it meanwhile
+    uint64_t sequence = slot.sequence.load(memory_order_acquire);
+    uint64_t header = slot.header.load(memory_order_relaxed);
+    bool same = slot.board_hash.load(memory_order_relaxed) == board_hash && slot.rack.load(memory_order_relaxed) == key
+                && slot.context.load(memory_order_relaxed) == context;
+    uint64_t words[WORDS_PER_MOVE * MAX_MOVES];
+    for (size_t i = 0; i < WORDS_PER_MOVE * MAX_MOVES; i++) {
+        words[i] = slot.moves[i].load(memory_order_relaxed);
+    }
+    atomic_thread_fence(memory_order_acquire);
+    size_t keep = header & 0xFF;
+    size_t held = min(static_cast<size_t>(header >> 8 & 0xFF), static_cast<size_t>(MAX_MOVES));
+    if (sequence % 2 == 1 || slot.sequence.load(memory_order_relaxed) != sequence || !same || keep < count) {
+        misses.fetch_add(1, memory_order_relaxed);
+        return false;
+    }
+
+    for (size_t i = 0; i < held && i < count; i++) {
+        const uint64_t* word = words + WORDS_PER_MOVE * i;
+        CompactMove move;
+        uint16_t points;
+        double equity;
+        memcpy(static_cast<void*>(&move), word, sizeof(move));
+        memcpy(&points, reinterpret_cast<const char*>(word) + sizeof(move), sizeof(points));
+        memcpy(&equity, &word[3], sizeof(equity));
+        moves.push_back(Hit{move.to_move(), points, equity});
+    }
+    hits.fetch_add(1, memory_order_relaxed);
+    return true;
+}
+
+void TranspositionCache::store(
+        uint64_t board_hash, const vector<TileKind>& rack, uint64_t context, size_t keep, const vector<Hit>& moves) {
+    if (keep == 0 || keep > MAX_MOVES || rack.size() > MAX_TILES) {
+        return;
+    }
+    uint64_t words[WORDS_PER_MOVE * MAX_MOVES] = {};
+    size_t held = min(moves.size(), keep);
+    for (size_t i = 0; i < held; i++) {
+        if (!CompactMove::fits(moves[i].move) || moves[i].points > UINT16_MAX) {
+            return;
+        }
+        uint64_t* word = words + WORDS_PER_MOVE * i;
+        CompactMove move(moves[i].move);
+        uint16_t points = moves[i].points;
+        memcpy(word, &move, sizeof(move));
+        memcpy(reinterpret_cast<char*>(word) + sizeof(move), &points, sizeof(points));
+        memcpy(&word[3], &moves[i].equity, sizeof(moves[i].equity));
+    }
+
+    uint64_t key = rack_key(rack);
+    Slot& slot = slot_for(board_hash, key, context);
+    // claim the slot by making its sequence odd; if another writer has it, this store is dropped
+    uint64_t sequence = slot.sequence.load(memory_order_relaxed);
+    if (sequence % 2 == 1 || !slot.sequence.compare_exchange_strong(sequence, sequence + 1, memory_order_acquire)) {
+        dropped.fetch_add(1, memory_order_relaxed);
+        return;
+    }
+    atomic_thread_fence(memory_order_release);
+    slot.board_hash.store(board_hash, memory_order_relaxed);
+    slot.rack.store(key, memory_order_relaxed);
+    slot.context.store(context, memory_order_relaxed);
+    slot.header.store(keep | held << 8, memory_order_relaxed);
+    for (size_t i = 0; i < WORDS_PER_MOVE * MAX_MOVES; i++) {
+        slot.moves[i].store(words[i], memory_order_relaxed);
+    }
+    slot.sequence.store(sequence + 2, memory_order_release);
+    stores.fetch_add(1, memory_order_relaxed);
+}
+
+TranspositionCache::Stats TranspositionCache::get_stats() const {
+    Stats stats;
+    stats.hits = hits.load(memory_order_relaxed);
+    stats.misses = misses.load(memory_order_relaxed);
+    stats.stores = stores.load(memory_order_relaxed);
+    stats.dropped = dropped.load(memory_order_relaxed);
+    return stats;
+}
+
+void TranspositionCache::reset_stats() {
+    hits = 0;
+    misses = 0;
+    stores = 0;
+    dropped = 0;
+}
@@ -0,0 +1,127 @@
+#ifndef TRANSPOSITION_CACHE_H
+#define TRANSPOSITION_CACHE_H
+
+#include "move.h"
+#include "tile_kind.h"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+/*
+The best moves found for a board and a rack, so that a position reached again, by a replay, a different move order
+or another request for the same hint, is answered without searching.
+
+A position is keyed by the Zobrist hash of the board (see Board::get_hash), the rack packed into 64 bits (see
+rack_key) and a context word for everything else the moves depend on, such as the dictionary and the leave table.
+The cache is a fixed array of slots, a power of two of them, and every key has exactly one slot, so a store simply
+replaces whatever the slot held.
+
+Any number of threads may find and store at once without locking. Every slot is guarded by a sequence number that a
+writer makes odd while it writes: a reader that sees it odd or changed treats the slot as a miss, and a writer that
+finds it odd drops its store rather than wait.
+
+Only racks of up to MAX_TILES tiles and at most MAX_MOVES moves per position are kept.
+*/
+class TranspositionCache {
+  public:
+    static const size_t MAX_TILES = 8;
+    static const size_t MAX_MOVES = 4;
+
+    /*
+    A move as it was stored, with the points it scores and its equity
+    */
+    struct Hit {
+        Move move;
+        size_t points;
+        double equity;
+    };
+
+    /*
+    hits, misses: finds that did and did not return moves
+    stores: stores that were written
+    dropped: stores left out because another thread was writing the same slot
+    */
+    struct Stats {
+        size_t hits = 0;
+        size_t misses = 0;
+        size_t stores = 0;
+        size_t dropped = 0;
+    };
+
+    /*
+    Makes a cache of at least `slots` slots, rounded up to a power of two
+    */
+    TranspositionCache(size_t slots);
+
+    TranspositionCache(const TranspositionCache&) = delete;
+    TranspositionCache& operator=(const TranspositionCache&) = delete;
+
+    /*
+    Returns the letters of the rack, sorted, a byte each, which is the same for two racks exactly when they hold the
+    same letters. The rack must hold at most MAX_TILES tiles.
+    */
+    static uint64_t rack_key(const std::vector<TileKind>& rack);
+
+    /*
+    Looks up the best moves for rack on the board with the given hash, in the given context. On a hit, moves is set
+    to the first count of them, best first, and true is returned. A position whose moves were stored for fewer than
+    count moves is a miss.
+    */
+    bool find(
+            uint64_t board_hash,
+            const std::vector<TileKind>& rack,
+            uint64_t context,
+            size_t count,
+            std::vector<Hit>& moves) const;
+
+    /*
+    Stores the best moves for rack on the board, best first, found when keep moves were asked for; moves holds fewer
+    if the position has fewer. Positions asked for more than MAX_MOVES, or with a move that does not fit a
+    CompactMove, are not stored.
+    */
+    void store(
+            uint64_t board_hash,
+            const std::vector<TileKind>& rack,
+            uint64_t context,
+            size_t keep,
+            const std::vector<Hit>& moves);
+
+    Stats get_stats() const;
+
+    void reset_stats();
+
+    size_t size() const { return slot_count; }
+
+  private:
+    static const size_t WORDS_PER_MOVE = 4;
+    static_assert(sizeof(CompactMove) + sizeof(uint16_t) <= 3 * sizeof(uint64_t), "a move and its points fill 3 words");
+
+    /*
+    sequence: even while the slot is at rest, odd while it is being written
+    board_hash, rack, context: the key of the position held
+    header: how many moves were asked for in the low byte, 0 for an empty slot, and how many are held in the next
+    moves: four words per move: the move as a CompactMove with its points in the two bytes after it, then the bits
+        of its equity
+    Every word is atomic, so a reader racing a writer reads torn data at worst, which the sequence number catches.
+    */
+    struct Slot {
+        std::atomic<uint64_t> sequence{0};
+        std::atomic<uint64_t> board_hash{0};
+        std::atomic<uint64_t> rack{0};
+        std::atomic<uint64_t> context{0};
+        std::atomic<uint64_t> header{0};
+        std::atomic<uint64_t> moves[WORDS_PER_MOVE * MAX_MOVES];
+    };
+
+    size_t slot_count;
+    std::unique_ptr<Slot[]> slots;
+    mutable std::atomic<size_t> hits{0};
+    mutable std::atomic<size_t> misses{0};
+    std::atomic<size_t> stores{0};
+    std::atomic<size_t> dropped{0};
+
+    Slot& slot_for(uint64_t board_hash, uint64_t rack, uint64_t context) const;
+};
+
+#endif
@@ -0,0 +1,115 @@
+#include "work_stealing_pool.h"
+
+using namespace std;
+
+WorkStealingPool::WorkStealingPool(size_t threads) : workers(threads == 0 ? 1 : threads) {
+    for (size_t i = 0; i < workers; i++) {
+        queues.push_back(make_unique<Queue>());
+    }
+    for (size_t i = 1; i < workers; i++) {
+        this->threads.emplace_back(&WorkStealingPool::work, this, i);
+    }
+}
+
+WorkStealingPool::~WorkStealingPool() {
+    {
+        lock_guard<mutex> guard(state_lock);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (size_t i = 0; i < threads.size(); i++) {
+        threads[i].join();
+    }
+}
+
+void WorkStealingPool::run(size_t count, const function<void(size_t, size_t)>& task) {
+    lock_guard<mutex> serialize(run_lock);
+
+    // split the indices into one contiguous block per worker
+    size_t begin = 0;
+    for (size_t i = 0; i < workers; i++) {
+        size_t end = begin + count / workers + (i < count % workers ? 1 : 0);
+        lock_guard<mutex> guard(queues[i]->lock);
+        for (size_t index = begin; index < end; index++) {
+            queues[i]->tasks.push_back(index);
+        }
+        begin = end;
+    }
+
+    {
+        lock_guard<mutex> guard(state_lock);
+        job = &task;
+        failure = nullptr;
+        busy = workers;
+        generation++;
+    }
+    wake.notify_all();
+
+    drain(0);
+
+    unique_lock<mutex> guard(state_lock);
+    done.wait(guard, [this] { return busy == 0; });
+    job = nullptr;
+    if (failure) {
+        exception_ptr error = failure;
+        failure = nullptr;
+        rethrow_exception(error);
+    }
+}
+
+void WorkStealingPool::work(size_t worker) {
+    size_t seen = 0;
+    while (true) {
+        {
+            unique_lock<mutex> guard(state_lock);
+            wake.wait(guard, [this, seen] { return stopping || generation != seen; });
+            if (stopping) {
+                return;
+            }
+            seen = generation;
+        }
+        drain(worker);
+    }
+}
+
+void WorkStealingPool::drain(size_t worker) {
+    size_t index;
+    while (next_task(worker, index)) {
+        try {
+            (*job)(worker, index);
+        } catch (...) {
+            lock_guard<mutex> guard(state_lock);
+            if (!failure) {
+                failure = current_exception();
+            }
+        }
+    }
+
+    lock_guard<mutex> guard(state_lock);
+    busy--;
+    if (busy == 0) {
+        done.notify_all();
+    }
+}
+
+bool WorkStealingPool::next_task(size_t worker, size_t& index) {
+    // own block first, taken from the back so the front stays cold for thieves
+    {
+        lock_guard<mutex> guard(queues[worker]->lock);
+        if (!queues[worker]->tasks.empty()) {
+            index = queues[worker]->tasks.back();
+            queues[worker]->tasks.pop_back();
+            return true;
+        }
+    }
+    for (size_t offset = 1; offset < workers; offset++) {
+        Queue& victim = *queues[(worker + offset) % workers];
+        lock_guard<mutex> guard(victim.lock);
+        if (!victim.tasks.empty()) {
+            index = victim.tasks.front();
+            victim.tasks.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,66 @@
+#ifndef WORK_STEALING_POOL_H
+#define WORK_STEALING_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class WorkStealingPool {
+  public:
+    /*
+    Creates a pool that runs tasks on `threads` workers.
+
+    The thread calling run() is always worker 0, so a pool of size n only starts n - 1 background threads.
+    A size of 0 is treated as 1.
+    */
+    WorkStealingPool(size_t threads);
+    ~WorkStealingPool();
+
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    size_t size() const { return workers; }
+
+    /*
+    Calls task(worker, index) once for every index in [0, count) and returns when all of them are done.
+
+    Indices are handed out to the workers in contiguous blocks. A worker that runs out of its own indices steals from
+    the front of another worker's block, so uneven tasks still keep every worker busy.
+    If a task throws, the first exception is rethrown here once the remaining tasks have finished.
+    Calls to run() are serialized; it must not be called from inside a task.
+    */
+    void run(size_t count, const std::function<void(size_t, size_t)>& task);
+
+  private:
+    struct Queue {
+        std::mutex lock;
+        std::deque<size_t> tasks;
+    };
+
+    size_t workers;
+    std::vector<std::unique_ptr<Queue>> queues;
+    std::vector<std::thread> threads;
+
+    std::mutex run_lock;
+    std::mutex state_lock;
+    std::condition_variable wake;
+    std::condition_variable done;
+    const std::function<void(size_t, size_t)>* job = nullptr;
+    size_t generation = 0;
+    size_t busy = 0;
+    bool stopping = false;
+    std::exception_ptr failure;
+
+    void work(size_t worker);
+    void drain(size_t worker);
+    bool next_task(size_t worker, size_t& index);
+};
+
+#endif
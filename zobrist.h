@@ -0,0 +1,20 @@
+#ifndef ZOBRIST_H
+#define ZOBRIST_H
+
+#include <cstdint>
+
+/*
+Zobrist hashing gives every (square, tile) pair its own random 64-bit key and hashes a position as the XOR of the keys
+of everything in it, so placing or removing a tile updates the hash with a single XOR.
+
+Instead of a table of random keys, a key is the splitmix64 finalizer of the pair's index, which is just as well
+spread and works for boards of any size.
+*/
+inline uint64_t zobrist_key(uint64_t index) {
+    uint64_t z = index + 0x9E3779B97F4A7C15ull;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+#endif